@@ -0,0 +1,201 @@
+#include <benchmark/benchmark.h>
+
+#include "factory.hpp"
+#include "generator.hpp"
+#include "reports.hpp"
+#include "simulation.hpp"
+
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+
+/// Generated structure with `workers` workers (10 per ramp, 1 storehouse per 100 workers)
+const std::string& generated_structure(std::int64_t workers)
+{
+    static std::map<std::int64_t, std::string> cache;
+    if (auto it = cache.find(workers); it != cache.end())
+    {
+        return it->second;
+    }
+
+    FactoryGeneratorParameters params;
+    params.workers = static_cast<std::size_t>(workers);
+    params.ramps = std::max<std::size_t>(1, params.workers / 10);
+    params.storehouses = std::max<std::size_t>(1, params.workers / 100);
+    params.fan_out = 3;
+    params.chain_depth = 8;
+    params.cycles = params.workers / 100;
+
+    std::ostringstream oss;
+    BufferedWriter writer(oss);
+    generate_factory_structure(params, writer);
+    return cache.emplace(workers, oss.str()).first->second;
+}
+
+Factory generated_factory(std::int64_t workers, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+{
+    std::istringstream iss(generated_structure(workers));
+    return load_factory_structure(iss, resource);
+}
+
+static void BM_LoadFactoryStructure(benchmark::State& state)
+{
+    const std::string& structure = generated_structure(state.range(0));
+    for (auto _ : state)
+    {
+        std::istringstream iss(structure);
+        Factory factory = load_factory_structure(iss);
+        benchmark::DoNotOptimize(factory.ramp_cbegin());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(structure.size()));
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_LoadFactoryStructure)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond)->Complexity();
+
+static void BM_SaveFactoryStructure(benchmark::State& state)
+{
+    Factory factory = generated_factory(state.range(0));
+    for (auto _ : state)
+    {
+        std::ostringstream oss;
+        save_factory_structure(factory, oss);
+        benchmark::DoNotOptimize(oss.str().size());
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_SaveFactoryStructure)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond)->Complexity();
+
+static void BM_IsConsistent(benchmark::State& state)
+{
+    Factory factory = generated_factory(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(factory.is_consistent());
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_IsConsistent)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond)->Complexity();
+
+static void BM_StructureReport(benchmark::State& state)
+{
+    Factory factory = generated_factory(state.range(0));
+    for (auto _ : state)
+    {
+        std::ostringstream oss;
+        generate_structure_report(factory, oss);
+        benchmark::DoNotOptimize(oss.str().size());
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_StructureReport)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond)->Complexity();
+
+static void BM_TurnReport(benchmark::State& state)
+{
+    /// Report of a factory after some turns, so that queues and stockpiles are not empty
+    Factory factory = generated_factory(state.range(0));
+    simulate(factory, 20, [](Factory&, Time) {});
+
+    for (auto _ : state)
+    {
+        std::ostringstream oss;
+        generate_simulation_turn_report(factory, oss, 20);
+        benchmark::DoNotOptimize(oss.str().size());
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_TurnReport)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond)->Complexity();
+
+static void BM_SimulationTurns(benchmark::State& state)
+{
+    constexpr TimeOffset turns = 50;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        Factory factory = generated_factory(state.range(0));
+        state.ResumeTiming();
+
+        simulate(factory, turns, [](Factory&, Time) {});
+
+        state.PauseTiming();
+        factory = Factory();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * turns);
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_SimulationTurns)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond)->Complexity();
+
+static void BM_SimulationTurnsPooled(benchmark::State& state)
+{
+    /// BM_SimulationTurns with the queues of each run in a pool released in one shot
+    constexpr TimeOffset turns = 50;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto pool = std::make_unique<std::pmr::unsynchronized_pool_resource>();
+        Factory factory = generated_factory(state.range(0), pool.get());
+        state.ResumeTiming();
+
+        simulate(factory, turns, [](Factory&, Time) {});
+
+        state.PauseTiming();
+        factory = Factory();
+        pool.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * turns);
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_SimulationTurnsPooled)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond)->Complexity();
+
+static void BM_TurnPassingMode(benchmark::State& state)
+{
+    /// Full turns with sequential (0) or batched (1) package passing
+    Factory factory = generated_factory(state.range(0));
+    factory.enable_batched_passing(state.range(1) != 0);
+    Time t = 1;
+    for (auto _ : state)
+    {
+        factory.do_deliveries(t);
+        factory.do_package_passing();
+        factory.do_work(t);
+        ++t;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(state.range(1) != 0 ? "batched" : "sequential");
+}
+BENCHMARK(BM_TurnPassingMode)->ArgsProduct({{1000, 10000}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+static void BM_LinearChains(benchmark::State& state)
+{
+    /// 100 chains ramp -> worker -> worker -> storehouse, turn by turn (0) or with skip-ahead (1)
+    std::ostringstream structure;
+    for (int i = 1; i <= 100; ++i)
+    {
+        structure << "LOADING_RAMP id=" << i << " delivery-interval=" << 2 + i % 4 << "\n"
+                  << "WORKER id=" << 2 * i - 1 << " processing-time=1 queue-type=FIFO\n"
+                  << "WORKER id=" << 2 * i << " processing-time=1 queue-type=LIFO\n"
+                  << "STOREHOUSE id=" << i << " stockpile-type=COUNTER\n"
+                  << "LINK src=ramp-" << i << " dest=worker-" << 2 * i - 1 << "\n"
+                  << "LINK src=worker-" << 2 * i - 1 << " dest=worker-" << 2 * i << "\n"
+                  << "LINK src=worker-" << 2 * i << " dest=store-" << i << "\n";
+    }
+
+    constexpr TimeOffset turns = 10000;
+    SimulationOptions options;
+    options.skip_ahead = state.range(0) != 0 ? turns : 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::istringstream iss(structure.str());
+        Factory factory = load_factory_structure(iss);
+        state.ResumeTiming();
+
+        simulate(factory, turns, [](Factory&, Time) {}, options);
+    }
+    state.SetItemsProcessed(state.iterations() * turns);
+    state.SetLabel(state.range(0) != 0 ? "skip-ahead" : "stepped");
+}
+BENCHMARK(BM_LinearChains)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,306 @@
+#include <benchmark/benchmark.h>
+
+#include "nodes.hpp"
+#include "package.hpp"
+#include "package_handle.hpp"
+#include "scheduler.hpp"
+#include "storage_types.hpp"
+
+#include <memory>
+#include <vector>
+
+// == Package ==
+
+static void BM_PackageCreateDestroy(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        Package p;
+        benchmark::DoNotOptimize(p.get_id());
+    }
+}
+BENCHMARK(BM_PackageCreateDestroy);
+
+static void BM_PackageCreateDestroyMany(benchmark::State& state)
+{
+    /// Many live packages - cost of the ID bookkeeping grows with the number of assigned IDs
+    std::vector<Package> live(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        Package p;
+        benchmark::DoNotOptimize(p.get_id());
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_PackageCreateDestroyMany)->Range(1 << 10, 1 << 18)->Complexity();
+
+static void BM_PackageMove(benchmark::State& state)
+{
+    Package a;
+    Package b;
+    for (auto _ : state)
+    {
+        Package tmp(std::move(a));
+        a = std::move(b);
+        b = std::move(tmp);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_PackageMove);
+
+// == PackageQueue ==
+
+static void BM_PackageQueuePushPop(benchmark::State& state)
+{
+    PackageQueue queue(static_cast<PackageQueueType>(state.range(0)));
+    for (std::int64_t i = 0; i < state.range(1); ++i)
+    {
+        queue.push(Package());
+    }
+
+    for (auto _ : state)
+    {
+        queue.push(Package());
+        Package p = queue.pop();
+        benchmark::DoNotOptimize(p.get_id());
+    }
+    state.SetLabel(state.range(0) == static_cast<std::int64_t>(PackageQueueType::FIFO) ? "FIFO" : "LIFO");
+}
+BENCHMARK(BM_PackageQueuePushPop)
+    ->ArgsProduct({{static_cast<std::int64_t>(PackageQueueType::FIFO), static_cast<std::int64_t>(PackageQueueType::LIFO)}, {0, 1 << 12}});
+
+static void BM_PackageQueueFillDrain(benchmark::State& state)
+{
+    PackageQueue queue(static_cast<PackageQueueType>(state.range(0)));
+    for (auto _ : state)
+    {
+        for (std::int64_t i = 0; i < state.range(1); ++i)
+        {
+            queue.push(Package());
+        }
+        while (!queue.empty())
+        {
+            benchmark::DoNotOptimize(queue.pop().get_id());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+    state.SetLabel(state.range(0) == static_cast<std::int64_t>(PackageQueueType::FIFO) ? "FIFO" : "LIFO");
+}
+BENCHMARK(BM_PackageQueueFillDrain)
+    ->ArgsProduct({{static_cast<std::int64_t>(PackageQueueType::FIFO), static_cast<std::int64_t>(PackageQueueType::LIFO)}, {64, 4096}});
+
+// == ReceiverPreferences ==
+
+static void BM_ChooseReceiver(benchmark::State& state)
+{
+    std::vector<Storehouse> storehouses;
+    for (std::int64_t i = 0; i < state.range(0); ++i)
+    {
+        storehouses.emplace_back(static_cast<ElementID>(i + 1));
+    }
+
+    ReceiverPreferences preferences;
+    for (auto& storehouse : storehouses)
+    {
+        preferences.add_receiver(&storehouse);
+    }
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(preferences.choose_receiver());
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ChooseReceiver)->RangeMultiplier(4)->Range(1, 1024)->Complexity();
+
+static void BM_PackageQueueBulkFillDrain(benchmark::State& state)
+{
+    /// Same work as BM_PackageQueueFillDrain with one virtual call per batch
+    std::unique_ptr<IPackageQueue> queue = std::make_unique<PackageQueue>(static_cast<PackageQueueType>(state.range(0)));
+    std::vector<Package> batch;
+    for (auto _ : state)
+    {
+        batch.resize(static_cast<std::size_t>(state.range(1)));
+        queue->push_bulk(std::move(batch));
+        queue->pop_n(queue->size(), batch);
+        benchmark::DoNotOptimize(batch.data());
+        batch.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+    state.SetLabel(state.range(0) == static_cast<std::int64_t>(PackageQueueType::FIFO) ? "FIFO" : "LIFO");
+}
+BENCHMARK(BM_PackageQueueBulkFillDrain)
+    ->ArgsProduct({{static_cast<std::int64_t>(PackageQueueType::FIFO), static_cast<std::int64_t>(PackageQueueType::LIFO)}, {64, 4096}});
+
+static void BM_PackageQueueDrainInto(benchmark::State& state)
+{
+    PackageQueue source(PackageQueueType::FIFO);
+    PackageQueue target(PackageQueueType::FIFO);
+    for (std::int64_t i = 0; i < state.range(0); ++i)
+    {
+        source.push(Package());
+    }
+    for (auto _ : state)
+    {
+        source.drain_into(target);
+        target.drain_into(source);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 2);
+}
+BENCHMARK(BM_PackageQueueDrainInto)->Range(64, 4096);
+
+// == Worker ==
+
+template <typename WorkerT>
+static void run_worker_turns(WorkerT& worker, benchmark::State& state)
+{
+    Storehouse storehouse(1, std::make_unique<CountingStockpile>());
+    worker.receiver_preferences_.add_receiver(&storehouse);
+    for (std::int64_t i = 0; i < state.range(0); ++i)
+    {
+        worker.receive_package(Package());
+    }
+
+    Time t = 1;
+    for (auto _ : state)
+    {
+        worker.receive_package(Package());
+        worker.do_work(t++);
+        worker.send_package();
+    }
+}
+
+static void BM_WorkerTurn(benchmark::State& state)
+{
+    Worker worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO));
+    run_worker_turns(worker, state);
+}
+BENCHMARK(BM_WorkerTurn)->Arg(0)->Arg(1 << 10);
+
+static void BM_StaticWorkerTurn(benchmark::State& state)
+{
+    StaticWorker<PackageQueueType::FIFO> worker(1, 1);
+    run_worker_turns(worker, state);
+}
+BENCHMARK(BM_StaticWorkerTurn)->Arg(0)->Arg(1 << 10);
+
+// == PackageHandle ==
+
+static void BM_PackageHandleQueueFillDrain(benchmark::State& state)
+{
+    /// BM_PackageQueueFillDrain with handles - IDs minted and retired by a ledger
+    PackageLedger ledger;
+    PackageHandleQueue queue(static_cast<PackageQueueType>(state.range(0)));
+    for (auto _ : state)
+    {
+        for (std::int64_t i = 0; i < state.range(1); ++i)
+        {
+            queue.push(ledger.mint());
+        }
+        while (!queue.empty())
+        {
+            ledger.retire(queue.pop());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+    state.SetLabel(state.range(0) == static_cast<std::int64_t>(PackageQueueType::FIFO) ? "FIFO" : "LIFO");
+}
+BENCHMARK(BM_PackageHandleQueueFillDrain)
+    ->ArgsProduct({{static_cast<std::int64_t>(PackageQueueType::FIFO), static_cast<std::int64_t>(PackageQueueType::LIFO)}, {64, 4096}});
+
+static void BM_PackageHandleQueueBulkMove(benchmark::State& state)
+{
+    PackageLedger ledger;
+    PackageHandleQueue source(PackageQueueType::FIFO);
+    PackageHandleQueue target(PackageQueueType::FIFO);
+    std::vector<PackageHandle> batch(static_cast<std::size_t>(state.range(0)));
+    for (std::int64_t i = 0; i < state.range(0); ++i)
+    {
+        source.push(ledger.mint());
+    }
+    for (auto _ : state)
+    {
+        std::size_t n = source.pop_n(batch.size(), batch.data());
+        target.push_bulk(batch.data(), n);
+        n = target.pop_n(batch.size(), batch.data());
+        source.push_bulk(batch.data(), n);
+    }
+    while (!source.empty())
+    {
+        ledger.retire(source.pop());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 2);
+}
+BENCHMARK(BM_PackageHandleQueueBulkMove)->Range(64, 4096);
+
+static void BM_StorehouseReceive(benchmark::State& state)
+{
+    /// Arrivals into the default list stockpile (0) and into handles (1, stockpile-type=HANDLES)
+    for (auto _ : state)
+    {
+        std::unique_ptr<IPackageStockpile> stockpile;
+        if (state.range(0) == 0) {stockpile = std::make_unique<PackageQueue>(PackageQueueType::LIFO);}
+        else {stockpile = std::make_unique<HandleStockpile>();}
+        Storehouse storehouse(1, std::move(stockpile));
+        for (std::int64_t i = 0; i < state.range(1); ++i)
+        {
+            storehouse.receive_package(Package());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+    state.SetLabel(state.range(0) == 0 ? "list" : "handles");
+}
+BENCHMARK(BM_StorehouseReceive)->ArgsProduct({{0, 1}, {64, 4096}});
+
+// == CountdownScheduler ==
+
+static std::vector<TimeOffset> bench_periods(std::int64_t n)
+{
+    std::vector<TimeOffset> periods;
+    for (std::int64_t i = 0; i < n; ++i)
+    {
+        periods.push_back(static_cast<TimeOffset>(i % 13 + 1));
+    }
+    return periods;
+}
+
+static void BM_FireTurnsModulo(benchmark::State& state)
+{
+    std::vector<TimeOffset> periods = bench_periods(state.range(0));
+    std::vector<std::uint32_t> fired;
+    Time t = 1;
+    for (auto _ : state)
+    {
+        fired.clear();
+        for (std::size_t i = 0; i < periods.size(); ++i)
+        {
+            if (t % periods[i] == 0) {fired.push_back(static_cast<std::uint32_t>(i));}
+        }
+        benchmark::DoNotOptimize(fired.data());
+        ++t;
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FireTurnsModulo)->Range(1 << 10, 1 << 16);
+
+static void BM_FireTurnsCountdown(benchmark::State& state)
+{
+    auto kernel = static_cast<SchedulerKernel>(state.range(1));
+    if (!CountdownScheduler::is_supported(kernel))
+    {
+        state.SkipWithError("Kernel not supported by the CPU");
+        return;
+    }
+    CountdownScheduler scheduler(kernel);
+    scheduler.set_periods(bench_periods(state.range(0)));
+    Time t = 1;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(scheduler.advance(t++).data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FireTurnsCountdown)
+    ->ArgsProduct({{1 << 10, 1 << 16}, {static_cast<std::int64_t>(SchedulerKernel::SCALAR),
+                                         static_cast<std::int64_t>(SchedulerKernel::SSE2),
+                                         static_cast<std::int64_t>(SchedulerKernel::AVX2)}});
@@ -0,0 +1,88 @@
+#ifndef SYMULACJASIECI_ASYNC_REPORTS_HPP
+#define SYMULACJASIECI_ASYNC_REPORTS_HPP
+
+#include "factory.hpp"
+#include "buffered_writer.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Package ID 0 marks an empty buffer (valid IDs start at 1)
+struct WorkerSnapshot
+{
+    ElementID id;
+    ElementID processing_buffer;
+    Time processing_start_time;
+    ElementID sending_buffer;
+    std::size_t queue_begin;    /// Range in TurnSnapshot::packages
+    std::size_t queue_end;
+};
+
+struct StorehouseSnapshot
+{
+    ElementID id;
+    std::size_t stock_begin;    /// Range in TurnSnapshot::packages
+    std::size_t stock_end;
+};
+
+/// Reportable state of a factory at the end of a turn - everything the turn report prints
+struct TurnSnapshot
+{
+    Time time = 0;
+    std::vector<WorkerSnapshot> workers;
+    std::vector<StorehouseSnapshot> storehouses;
+    std::vector<ElementID> packages;
+};
+
+/// Overwrites the snapshot, reusing its capacity
+void take_turn_snapshot(const Factory& f, Time t, TurnSnapshot& snapshot);
+
+/// Same text as generate_simulation_turn_report for the factory the snapshot was taken from
+void generate_simulation_turn_report(const TurnSnapshot& snapshot, BufferedWriter& writer);
+
+
+/// Turn reports formatted and written on a background thread.
+/// Used as the report function of simulate(): the simulation thread only captures a snapshot,
+/// blocking when max_pending snapshots are already waiting.
+class AsyncReportWriter
+{
+public:
+    explicit AsyncReportWriter(std::ostream& os, std::size_t max_pending = 16);
+    explicit AsyncReportWriter(const std::string& path, std::size_t max_pending = 16);
+
+    AsyncReportWriter(const AsyncReportWriter&) = delete;
+    AsyncReportWriter& operator=(const AsyncReportWriter&) = delete;
+
+    ~AsyncReportWriter();
+
+    /// Throws std::logic_error after close()
+    void operator()(Factory& f, Time t);
+
+    /// Writes all pending reports and stops the thread; rethrows a write error of the background thread
+    void close();
+
+private:
+    void start();
+    void run();
+
+private:
+    BufferedWriter writer_;
+    std::size_t maxPending_;
+
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<TurnSnapshot> pending_;
+    std::vector<TurnSnapshot> recycled_;
+    bool closed_ = false;
+    std::exception_ptr error_;
+
+    std::thread thread_;
+};
+
+#endif //SYMULACJASIECI_ASYNC_REPORTS_HPP
@@ -0,0 +1,68 @@
+#ifndef SYMULACJASIECI_BUFFERED_WRITER_HPP
+#define SYMULACJASIECI_BUFFERED_WRITER_HPP
+
+#include <charconv>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/// Output sink formatting text into a reusable buffer and emitting it in large blocks.
+/// Writes either to a std::ostream or directly to a file descriptor (bypassing iostreams).
+class BufferedWriter
+{
+public:
+    static constexpr std::size_t default_capacity = 64 * 1024;
+
+    explicit BufferedWriter(std::ostream& os, std::size_t capacity = default_capacity);
+    explicit BufferedWriter(int fd, std::size_t capacity = default_capacity);
+    /// Opens (creates / truncates) the file and owns its descriptor.
+    explicit BufferedWriter(const std::string& path, std::size_t capacity = default_capacity);
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    ~BufferedWriter();
+
+    BufferedWriter& operator<<(std::string_view str) {return write(str.data(), str.size());}
+    BufferedWriter& operator<<(const char* str) {return *this << std::string_view(str);}
+    BufferedWriter& operator<<(char c);
+
+    template<typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer> && !std::is_same_v<Integer, bool> && !std::is_same_v<Integer, char>>>
+    BufferedWriter& operator<<(Integer value);
+
+    BufferedWriter& write(const void* data, std::size_t size);
+
+    /// Emits the buffered block to the underlying sink.
+    void flush();
+
+    [[nodiscard]] std::size_t buffered_size() const {return size_;}
+
+private:
+    void reserve(std::size_t n) {if (buffer_.size() - size_ < n) {drain();}}
+    void drain();
+    void emit(const char* data, std::size_t size);
+
+private:
+    std::vector<char> buffer_;
+    std::size_t size_ = 0;
+    std::ostream* os_ = nullptr;
+    int fd_ = -1;
+    bool ownsFd_ = false;
+};
+
+
+template<typename Integer, typename>
+BufferedWriter& BufferedWriter::operator<<(Integer value)
+{
+    constexpr std::size_t max_digits = 24;
+    reserve(max_digits);
+    auto [end, ec] = std::to_chars(buffer_.data() + size_, buffer_.data() + buffer_.size(), value);
+    static_cast<void>(ec);
+    size_ = static_cast<std::size_t>(end - buffer_.data());
+    return *this;
+}
+
+#endif //SYMULACJASIECI_BUFFERED_WRITER_HPP
@@ -0,0 +1,67 @@
+#ifndef SYMULACJASIECI_CONVERGENCE_HPP
+#define SYMULACJASIECI_CONVERGENCE_HPP
+
+#include "factory.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <vector>
+
+enum class StopReason
+{
+    COMPLETED,      /// All requested turns were simulated
+    STEADY_STATE,   /// Queue lengths and storehouse inflow stopped changing
+    DIVERGED        /// The queue of some worker grows without bound
+};
+
+struct ConvergenceParameters
+{
+    TimeOffset window = 100;            /// Turns per window - should be well above the longest interval / processing time
+    double tolerance = 0.05;            /// Allowed relative change of the window means between consecutive windows
+    std::size_t stable_windows = 3;     /// Consecutive unchanged windows meaning steady state
+    double queue_growth = 1.0;          /// Growth of a worker's mean queue length per window counted as divergent
+    std::size_t divergent_windows = 5;  /// Consecutive growing windows meaning divergence
+};
+
+/// Watches a running simulation in windows of turns: the mean total queue length and the storehouse
+/// inflow per turn (packages received, also by RING and COUNTER stockpiles and with statistics disabled).
+class ConvergenceMonitor
+{
+public:
+    /// Throws std::invalid_argument for a non-positive window or a zero window count
+    explicit ConvergenceMonitor(ConvergenceParameters params = {});
+
+    /// Samples the factory after turn t; COMPLETED means "keep going"
+    StopReason observe(const Factory& f, Time t);
+
+    /// Worker whose queue diverged (0 unless observe() returned DIVERGED)
+    [[nodiscard]] ElementID get_diverging_worker() const {return divergingWorker_;}
+
+    void reset();
+
+private:
+    StopReason close_window();
+
+private:
+    ConvergenceParameters params_;
+
+    TimeOffset turnsInWindow_ = 0;
+    double queueLengthSum_ = 0;
+    std::uint64_t lastStored_ = 0;
+    std::uint64_t inflowSum_ = 0;
+    bool hasLastStored_ = false;
+
+    bool hasPreviousWindow_ = false;
+    double previousQueueMean_ = 0;
+    double previousInflowMean_ = 0;
+    std::size_t stableStreak_ = 0;
+
+    /// Per worker, in collection order
+    std::vector<ElementID> workerIds_;
+    std::vector<double> workerQueueSums_;
+    std::vector<double> workerPreviousMeans_;
+    std::vector<std::size_t> workerGrowthStreaks_;
+    ElementID divergingWorker_ = 0;
+};
+
+#endif //SYMULACJASIECI_CONVERGENCE_HPP
@@ -3,14 +3,26 @@
 
 #include "types.hpp"
 #include "nodes.hpp"
+#include "buffered_writer.hpp"
+#include "scheduler.hpp"
+#include "memory_usage.hpp"
+#include "package_handle.hpp"
 
 #include <list>
+#include <memory>
+#include <memory_resource>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 
 ///
 /// \tparam Node - Ramps, Workers, Storehouses
+/// IDs are unique within a collection - lookups go through an ID index instead of a list scan.
 template <typename Node>
 class NodeCollection
 {
@@ -19,27 +31,38 @@ public:
     using iterator = typename container_t::iterator;
     using const_iterator = typename container_t::const_iterator;
 
+    /// Throws std::invalid_argument if a node with the same ID is already in the collection
     void add(Node &&node)
     {
+        auto [it, inserted] = index_.try_emplace(node.get_id());
+        if (!inserted)
+        {
+            throw std::invalid_argument("Duplicate node ID " + std::to_string(node.get_id()));
+        }
         nodeCollection_.push_back(std::move(node));
+        it->second = std::prev(nodeCollection_.end());
     }
 
     void remove_by_id(ElementID id)
     {
-        nodeCollection_.remove_if([id](const Node &node){return node.get_id() == id;});
+        if (auto it = index_.find(id); it != index_.end())
+        {
+            nodeCollection_.erase(it->second);
+            index_.erase(it);
+        }
     }
 
 
     [[nodiscard]] const_iterator find_by_id(ElementID id) const
     {
-        return std::find_if(nodeCollection_.cbegin(), nodeCollection_.cend(),
-                            [id](const Node &node){return node.get_id() == id;});
+        auto it = index_.find(id);
+        return it == index_.end() ? nodeCollection_.cend() : const_iterator(it->second);
     }
 
     iterator find_by_id(ElementID id)
     {
-        return std::find_if(nodeCollection_.begin(), nodeCollection_.end(),
-                            [id](const Node &node){return node.get_id() == id;});
+        auto it = index_.find(id);
+        return it == index_.end() ? nodeCollection_.end() : it->second;
     }
 
     iterator begin(){return nodeCollection_.begin();}
@@ -49,75 +72,250 @@ public:
     [[nodiscard]] const_iterator cbegin() const {return nodeCollection_.cbegin();}
     [[nodiscard]] const_iterator cend() const {return nodeCollection_.cend();}
 
+    /// Estimated heap bytes of the nodes (without what they hold themselves) and of the ID index
+    [[nodiscard]] std::size_t get_memory_usage() const
+    {
+        return nodeCollection_.size() * list_node_bytes<Node> + index_.bucket_count() * sizeof(void*)
+               + index_.size() * hash_node_bytes<typename decltype(index_)::value_type>;
+    }
+
 private:
     container_t nodeCollection_;
+    std::unordered_map<ElementID, iterator> index_;
 };
 
 
 class Factory
 {
 public:
+    /// Memory resource for the package queues and stockpiles of nodes created by the structure loader
+    /// and patches (e.g. an arena freed in one shot after the run); it has to outlive the factory.
+    /// Package IDs are process-wide and unsynchronized, so factories must not be simulated concurrently
+    explicit Factory(std::pmr::memory_resource* resource = std::pmr::get_default_resource()): memoryResource_{resource} {}
+
+    [[nodiscard]] std::pmr::memory_resource* get_memory_resource() const {return memoryResource_;}
+
     [[nodiscard]] bool is_consistent() const;
 
+    /// Estimated heap bytes of the three node collections (see collect_memory_usage for the rest)
+    [[nodiscard]] std::size_t get_collections_memory_usage() const
+    {
+        return rampCollection_.get_memory_usage() + workerCollection_.get_memory_usage() + storehouseCollection_.get_memory_usage();
+    }
+
     void do_deliveries(Time);
 
     void do_package_passing();
 
     void do_work(Time);
 
+    /// Change tracking - records workers and storehouses whose buffers, queue or stock were
+    /// changed by do_deliveries / do_package_passing / do_work (direct node calls are not tracked)
+    void set_change_tracking(bool enabled);
+    [[nodiscard]] bool is_change_tracking() const {return trackChanges_;}
+    [[nodiscard]] const std::unordered_set<const IPackageReceiver*>& get_changed_receivers() const {return changedReceivers_;}
+    void clear_changed_receivers() {changedReceivers_.clear();}
+
+    /// Statistics - counters updated by the nodes during the simulation (reset when enabled)
+    void enable_statistics(bool enabled);
+    [[nodiscard]] bool has_statistics() const {return statistics_ != nullptr;}
+    [[nodiscard]] const StatisticsCollector* get_statistics_collector() const {return statistics_.get();}
+
+    /// Countdown scheduling - delivery and finishing turns of ramps and workers come from per-node
+    /// countdowns stepped with SIMD (CountdownScheduler) instead of a division per node per turn
+    void enable_countdown_scheduling(bool enabled, SchedulerKernel kernel = SchedulerKernel::AUTO);
+    [[nodiscard]] bool is_countdown_scheduling() const {return rampSchedule_ != nullptr;}
+
+    /// Batched package passing - uniforms for all senders with a full buffer are drawn in one pass
+    /// (straight from rng for the default generator), receivers are resolved on the flat cumulative
+    /// tables and packages are handed off grouped by receiver. Same results as the sequential passing;
+    /// falls back to it while any worker queue is bounded (hand-off order decides who gets blocked).
+    void enable_batched_passing(bool enabled) {batchedPassing_ = enabled;}
+    [[nodiscard]] bool is_batched_passing() const {return batchedPassing_;}
+
+    /// Skip-ahead - runs turns [t, t + k). Deterministic chains (a ramp with one receiver, then unbounded
+    /// workers with one sender and one receiver each, ending in a storehouse) are stepped on their own
+    /// until their state repeats every lcm(delivery interval, processing times) turns up to growing queues,
+    /// and then jump whole periods; the rest of the graph is stepped turn by turn.
+    /// Buffers, queue lengths and stock sizes match stepping every turn; package IDs and the order of
+    /// packages in shared storehouses do not, and the rest of the graph sees a different sequence of draws
+    /// (chains no longer consume any). With statistics enabled every turn is stepped as usual.
+    void advance(Time t, TimeOffset k);
+
+    /// Package ledger - counts the packages in flight: minted by the ramps (packages already held by the nodes
+    /// and created in bulk by skip-ahead are adopted), retired at the storehouses and when their node is removed.
+    /// Off by default; it adds bookkeeping to every delivery and arrival.
+    void enable_package_ledger(bool enabled);
+    [[nodiscard]] const PackageLedger* get_package_ledger() const {return packageLedger_.get();}
+
     /// Ramp
-    void add_ramp(Ramp&& ramp){rampCollection_.add(std::move(ramp));}
-    void remove_ramp(ElementID id){rampCollection_.remove_by_id(id);}
+    void add_ramp(Ramp&& ramp)
+    {
+        ramp.attach_statistics(statistics_.get());
+        ramp.attach_package_ledger(packageLedger_.get());
+        adopt_packages(ramp);
+        rampCollection_.add(std::move(ramp));
+        schedulesDirty_ = true;
+    }
+    void remove_ramp(ElementID id);
 
     NodeCollection<Ramp>::iterator find_ramp_by_id(ElementID id){return rampCollection_.find_by_id(id);}
     [[nodiscard]] NodeCollection<Ramp>::const_iterator find_ramp_by_id(ElementID id) const{return rampCollection_.find_by_id(id);}
 
     [[nodiscard]] NodeCollection<Ramp>::const_iterator ramp_cbegin() const {return rampCollection_.cbegin();}
     [[nodiscard]] NodeCollection<Ramp>::const_iterator ramp_cend() const {return rampCollection_.cend();}
+    [[nodiscard]] NodeCollection<Ramp>::iterator ramp_begin() {return rampCollection_.begin();}
+    [[nodiscard]] NodeCollection<Ramp>::iterator ramp_end() {return rampCollection_.end();}
 
 
     /// Worker
-    void add_worker(Worker&& worker){workerCollection_.add(std::move(worker));}
+    void add_worker(Worker&& worker)
+    {
+        worker.attach_statistics(statistics_.get());
+        adopt_packages(worker);
+        workerCollection_.add(std::move(worker));
+        schedulesDirty_ = true;
+    }
     void remove_worker(ElementID id){remove_receiver(workerCollection_, id);}
+    /// Unlinks the worker only from the given senders, which have to include every sender linked to it
+    /// (O(degree) instead of a pass over all ramps and workers)
+    void remove_worker(ElementID id, const std::vector<PackageSender*>& senders){remove_receiver(workerCollection_, id, &senders);}
 
     NodeCollection<Worker>::iterator find_worker_by_id(ElementID id){return workerCollection_.find_by_id(id);}
     [[nodiscard]] NodeCollection<Worker>::const_iterator find_worker_by_id(ElementID id) const{return workerCollection_.find_by_id(id);}
 
     [[nodiscard]] NodeCollection<Worker>::const_iterator worker_cbegin() const {return workerCollection_.cbegin();}
     [[nodiscard]] NodeCollection<Worker>::const_iterator worker_cend() const {return workerCollection_.cend();}
+    [[nodiscard]] NodeCollection<Worker>::iterator worker_begin() {return workerCollection_.begin();}
+    [[nodiscard]] NodeCollection<Worker>::iterator worker_end() {return workerCollection_.end();}
 
     /// Storehouse
-    void add_storehouse(Storehouse&& storehouse){storehouseCollection_.add(std::move(storehouse));}
+    void add_storehouse(Storehouse&& storehouse)
+    {
+        storehouse.attach_statistics(statistics_.get());
+        storehouse.attach_package_ledger(packageLedger_.get());
+        storehouseCollection_.add(std::move(storehouse));
+    }
     void remove_storehouse(ElementID id){ remove_receiver(storehouseCollection_, id);}
+    /// As remove_worker(id, senders)
+    void remove_storehouse(ElementID id, const std::vector<PackageSender*>& senders){remove_receiver(storehouseCollection_, id, &senders);}
 
     NodeCollection<Storehouse>::iterator find_storehouse_by_id(ElementID id){ return storehouseCollection_.find_by_id(id);}
     [[nodiscard]] NodeCollection<Storehouse>::const_iterator find_storehouse_by_id(ElementID id) const{return storehouseCollection_.find_by_id(id);}
 
     [[nodiscard]] NodeCollection<Storehouse>::const_iterator storehouse_cbegin() const {return storehouseCollection_.cbegin();}
     [[nodiscard]] NodeCollection<Storehouse>::const_iterator storehouse_cend() const {return storehouseCollection_.cend();}
+    [[nodiscard]] NodeCollection<Storehouse>::iterator storehouse_end() {return storehouseCollection_.end();}
 
 private:
     /// Metoda usuwa element i połączenie
     /// Podczas usunięcia magazynu trzeba usunąc połączenie rampa/worker->magazyn
+    /// senders - nadawcy połączeni z węzłem (nullptr: wszystkie rampy i robotnicy)
     template<typename Node>
-    void remove_receiver(NodeCollection<Node> &collection, ElementID id);
+    void remove_receiver(NodeCollection<Node> &collection, ElementID id, const std::vector<PackageSender*>* senders = nullptr);
+
+    /// Packages held by a removed node leave the factory (storehouses retire theirs on arrival)
+    void retire_packages(const PackageSender& sender);
+    void retire_packages(const Worker& worker);
+    void retire_packages(const Storehouse&) {}
+    /// Packages held by a node count as in flight (no-op without the ledger)
+    void adopt_packages(const PackageSender& sender);
+    void adopt_packages(const Worker& worker);
+
+    /// Periods of the schedulers follow the order of the collections
+    void update_schedules();
+    void deliver_goods(Ramp& ramp, Time time, bool delivery_turn);
+    void do_work(Worker& worker, Time time, bool finishing_turn);
+    void do_batched_package_passing();
+
+    struct DeterministicChain
+    {
+        Ramp* ramp;
+        std::vector<Worker*> workers;   /// In chain order
+        Storehouse* storehouse;
+        TimeOffset period;              /// lcm of the delivery interval and processing times (0 = too long to jump)
+    };
+
+    std::vector<DeterministicChain> find_deterministic_chains(TimeOffset max_period);
+    void advance_chain(const DeterministicChain& chain, Time t, TimeOffset k);
+    /// Returns the number of packages which reached the storehouse
+    std::size_t step_chain(const DeterministicChain& chain, Time time);
+    /// Sends with change tracking; self is the sender as a receiver (nullptr for ramps)
+    IPackageReceiver* send_package(PackageSender& sender, IPackageReceiver* self, IPackageReceiver* receiver);
 
 private:
+    std::pmr::memory_resource* memoryResource_;
+    std::unique_ptr<PackageLedger> packageLedger_;
+
     NodeCollection<Ramp> rampCollection_;
     NodeCollection<Worker> workerCollection_;
     NodeCollection<Storehouse> storehouseCollection_;
+
+    bool trackChanges_ = false;
+    std::unordered_set<const IPackageReceiver*> changedReceivers_;
+
+    std::unique_ptr<StatisticsCollector> statistics_;
+
+    std::unique_ptr<CountdownScheduler> rampSchedule_;
+    std::unique_ptr<CountdownScheduler> workerSchedule_;
+    bool schedulesDirty_ = true;
+
+    struct PendingSend
+    {
+        PackageSender* sender;
+        IPackageReceiver* worker;       /// The sender as a receiver (nullptr for ramps) - for change tracking
+        IPackageReceiver* receiver;
+        std::size_t order;              /// Position in the sequential passing order
+    };
+
+    bool batchedPassing_ = false;
+    std::vector<PendingSend> pendingSends_;
 };
 
-Factory load_factory_structure(std::istream&);
+Factory load_factory_structure(std::istream&, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+/// Applies a structure patch to an existing factory, line by line:
+///   ADD <LOADING_RAMP|WORKER|STOREHOUSE> <parameters as in the structure file>
+///   REMOVE <LOADING_RAMP|WORKER|STOREHOUSE> id=<id>
+///   LINK src=<node> dest=<node>
+///   UNLINK src=<node> dest=<node>
+/// The whole patch is parsed and checked against the factory first: on malformed lines, unknown nodes
+/// (std::runtime_error) or duplicate node IDs (std::invalid_argument) it throws and the factory is left unchanged.
+void apply_factory_patch(Factory&, std::istream&);
 
 void save_factory_structure(Factory&, std::ostream&);
 
+/// Formats the structure straight into the writer's buffer (no per-line allocations)
+void save_factory_structure(const Factory&, BufferedWriter&);
+
+/// Writes to an open file descriptor, bypassing iostreams
+void save_factory_structure(const Factory&, int fd);
+
+void save_factory_structure(const Factory&, const std::string& path);
+
 
 template<typename Node>
-void Factory::remove_receiver(NodeCollection<Node> &collection, ElementID id)
+void Factory::remove_receiver(NodeCollection<Node> &collection, ElementID id, const std::vector<PackageSender*>* senders)
 {
+    auto iter = collection.find_by_id(id);
+    if (iter == collection.end()) {return;}
+
     /// *iterator = odbiorca, &odbiorca = wskaźnik do odbiorcy
-    auto pReciver = &(*collection.find_by_id(id));
+    auto pReciver = &(*iter);
+    changedReceivers_.erase(pReciver);
+
+    retire_packages(*iter);
+
+    if (senders)
+    {
+        for (PackageSender* sender : *senders)
+        {
+            sender->receiver_preferences_.remove_receiver(pReciver);
+        }
+        collection.remove_by_id(id);
+        schedulesDirty_ = true;
+        return;
+    }
 
     // Dla kazdej dostawcy towaru sprawdzasz czy dostarcza do tego odpbiory
     for (auto &ramp : rampCollection_)
@@ -130,6 +328,7 @@ void Factory::remove_receiver(NodeCollection<Node> &collection, ElementID id)
         worker.receiver_preferences_.remove_receiver(pReciver);
     }
     collection.remove_by_id(id);
+    schedulesDirty_ = true;
 }
 
 #endif //SYMULACJASIECI_FACTORY_HPP
@@ -0,0 +1,59 @@
+#ifndef SYMULACJASIECI_FLOW_HPP
+#define SYMULACJASIECI_FLOW_HPP
+
+#include "factory.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+enum class RampRateModel
+{
+    NOMINAL,    /// One package per delivery interval: 1 / di
+    SIMULATED   /// As Ramp::deliver_goods behaves: a package on every turn which is not a delivery turn, (di - 1) / di
+};
+
+struct FlowParameters
+{
+    RampRateModel ramp_rate = RampRateModel::NOMINAL;
+    double tolerance = 1e-12;           /// Largest change of an arrival rate in the last sweep
+    std::size_t max_iterations = 10000;
+};
+
+/// Rates in packages per turn
+struct WorkerFlow
+{
+    ElementID id;
+    double arrival_rate;
+    double service_rate;    /// 1 / processing time
+    double throughput;      /// min(arrival rate, service rate)
+    double utilization;     /// arrival rate / service rate
+    bool bottleneck;        /// utilization >= 1 - the queue grows without bound
+};
+
+struct StorehouseFlow
+{
+    ElementID id;
+    double arrival_rate;
+};
+
+struct FlowEstimate
+{
+    std::vector<WorkerFlow> workers;
+    std::vector<StorehouseFlow> storehouses;
+    double input_rate = 0;      /// Sum of the ramp rates
+    double output_rate = 0;     /// Sum of the storehouse arrival rates
+    std::size_t iterations = 0;
+    bool converged = false;
+};
+
+/// Expected steady-state flow without simulating: solves the flow balance
+///   arrival(w) = sum over ramps of rate * p(ramp -> w) + sum over workers v of min(arrival(v), service(v)) * p(v -> w)
+/// with Gauss-Seidel sweeps (exact for unsaturated workers, saturated ones pass on their service rate).
+/// Throws std::logic_error if the factory is not consistent.
+FlowEstimate estimate_flow(const Factory& f, const FlowParameters& params = {});
+
+void generate_flow_report(const FlowEstimate& estimate, std::ostream& os);
+
+#endif //SYMULACJASIECI_FLOW_HPP
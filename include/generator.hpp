@@ -0,0 +1,31 @@
+#ifndef SYMULACJASIECI_GENERATOR_HPP
+#define SYMULACJASIECI_GENERATOR_HPP
+
+#include "types.hpp"
+#include "buffered_writer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/// Shape of a synthetic factory. Workers are split into chain_depth layers:
+/// ramps feed the first layer, each layer feeds the next one and the last layer feeds storehouses.
+struct FactoryGeneratorParameters
+{
+    std::size_t ramps = 1;
+    std::size_t workers = 1;
+    std::size_t storehouses = 1;
+    std::size_t fan_out = 2;        /// Receivers per sender (capped by the size of the next layer)
+    std::size_t chain_depth = 1;    /// Number of worker layers
+    std::size_t cycles = 0;         /// Extra links from a worker back to the same or an earlier layer
+    double lifo_ratio = 0.5;        /// Fraction of workers with a LIFO queue
+    TimeOffset max_delivery_interval = 5;
+    TimeOffset max_processing_time = 5;
+    std::uint64_t seed = 1;
+};
+
+/// Emits a structure file (same format as save_factory_structure) which passes Factory::is_consistent.
+/// The structure is streamed - the factory is never built in memory.
+/// Throws std::invalid_argument if no consistent structure fits the parameters.
+void generate_factory_structure(const FactoryGeneratorParameters&, BufferedWriter&);
+
+#endif //SYMULACJASIECI_GENERATOR_HPP
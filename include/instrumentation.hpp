@@ -0,0 +1,128 @@
+#ifndef SYMULACJASIECI_INSTRUMENTATION_HPP
+#define SYMULACJASIECI_INSTRUMENTATION_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class InstrumentationCounter
+{
+    PACKAGES_MOVED,     /// Packages handed from a sender to a receiver
+    QUEUE_PUSHES,       /// Packages pushed to PackageQueues (worker queues and default stockpiles)
+    QUEUE_POPS,
+    RNG_DRAWS,          /// Draws from the default probability generator
+    COUNT
+};
+
+/// Process-wide recorder of timed phases ("X" events) and counters ("C" samples), written in the
+/// Chrome trace event format (chrome://tracing, Perfetto). Records only while enabled.
+class InstrumentationRecorder
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct PhaseTotals
+    {
+        std::uint64_t calls = 0;
+        std::uint64_t nanoseconds = 0;
+    };
+
+    /// Starts recording (clearing earlier events, totals and counters) or stops it
+    void enable(bool enabled, std::size_t max_events = 1000000);
+    [[nodiscard]] bool is_enabled() const {return enabled_.load(std::memory_order_relaxed);}
+
+    void add(InstrumentationCounter counter, std::uint64_t n)
+    {
+        if (is_enabled()) {counters_[static_cast<std::size_t>(counter)].fetch_add(n, std::memory_order_relaxed);}
+    }
+    [[nodiscard]] std::uint64_t get_counter(InstrumentationCounter counter) const
+    {
+        return counters_[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    /// name has to outlive the recorder (a string literal)
+    void record_phase(const char* name, clock::time_point start, clock::time_point end);
+    /// Current counter values as one trace sample
+    void sample_counters();
+
+    /// Totals of all phases, including those past max_events
+    [[nodiscard]] std::unordered_map<std::string_view, PhaseTotals> get_phase_totals() const;
+    [[nodiscard]] std::size_t get_dropped_events() const;
+
+    void write_chrome_trace(std::ostream& os) const;
+    /// Time per phase and counter values
+    void write_summary(std::ostream& os) const;
+
+private:
+    struct Event
+    {
+        const char* name;           /// nullptr for a counter sample
+        std::int64_t start;         /// Nanoseconds since enable()
+        std::int64_t duration;
+        std::uint32_t thread;
+        std::array<std::uint64_t, static_cast<std::size_t>(InstrumentationCounter::COUNT)> counters;
+    };
+
+    static std::uint32_t thread_index();
+
+    std::atomic<bool> enabled_{false};
+    std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(InstrumentationCounter::COUNT)> counters_{};
+
+    mutable std::mutex mutex_;
+    clock::time_point origin_;
+    std::size_t maxEvents_ = 0;
+    std::size_t droppedEvents_ = 0;
+    std::vector<Event> events_;
+    std::unordered_map<std::string_view, PhaseTotals> totals_;
+};
+
+InstrumentationRecorder& instrumentation();
+
+/// Records the lifetime of the scope as a phase
+class ScopedPhaseTimer
+{
+public:
+    explicit ScopedPhaseTimer(const char* name): name_{instrumentation().is_enabled() ? name : nullptr}
+    {
+        if (name_ != nullptr) {start_ = InstrumentationRecorder::clock::now();}
+    }
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+    ~ScopedPhaseTimer()
+    {
+        if (name_ != nullptr) {instrumentation().record_phase(name_, start_, InstrumentationRecorder::clock::now());}
+    }
+
+private:
+    const char* name_;
+    InstrumentationRecorder::clock::time_point start_;
+};
+
+
+/// Hot-path hooks - compiled in with the SYMULACJASIECI_INSTRUMENTATION CMake option, no code otherwise
+#ifdef SYMULACJASIECI_INSTRUMENTATION
+    constexpr bool instrumentation_compiled_in = true;
+
+    #define INSTRUMENT_CONCAT_(a, b) a##b
+    #define INSTRUMENT_SCOPE_NAME_(line) INSTRUMENT_CONCAT_(instrumentScope_, line)
+    #define INSTRUMENT_SCOPE(name) ScopedPhaseTimer INSTRUMENT_SCOPE_NAME_(__LINE__)(name)
+    #define INSTRUMENT_COUNT(counter, n) instrumentation().add(InstrumentationCounter::counter, n)
+    #define INSTRUMENT_SAMPLE_COUNTERS() (instrumentation().is_enabled() ? instrumentation().sample_counters() : static_cast<void>(0))
+#else
+    constexpr bool instrumentation_compiled_in = false;
+
+    #define INSTRUMENT_SCOPE(name) static_cast<void>(0)
+    #define INSTRUMENT_COUNT(counter, n) static_cast<void>(0)
+    #define INSTRUMENT_SAMPLE_COUNTERS() static_cast<void>(0)
+#endif
+
+#endif //SYMULACJASIECI_INSTRUMENTATION_HPP
@@ -0,0 +1,73 @@
+#ifndef SYMULACJASIECI_MEMORY_USAGE_HPP
+#define SYMULACJASIECI_MEMORY_USAGE_HPP
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <ostream>
+#include <vector>
+
+/// Heap bytes of one element of the node-based standard containers (libstdc++ and libc++ node layouts):
+/// list - two links, tree (map / set) - three links and the colour, hash table - the next link
+template <typename T> constexpr std::size_t list_node_bytes = 2 * sizeof(void*) + sizeof(T);
+template <typename T> constexpr std::size_t tree_node_bytes = 4 * sizeof(void*) + sizeof(T);
+template <typename T> constexpr std::size_t hash_node_bytes = sizeof(void*) + sizeof(T);
+
+
+/// Forwards to the upstream resource and counts what passes through, e.g. as the factory resource
+/// to check the queue and stockpile estimates against real allocations. Not synchronized.
+class CountingMemoryResource: public std::pmr::memory_resource
+{
+public:
+    explicit CountingMemoryResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()): upstream_{upstream} {}
+
+    [[nodiscard]] std::size_t get_bytes_in_use() const {return bytesInUse_;}
+    [[nodiscard]] std::size_t get_peak_bytes() const {return peakBytes_;}
+    [[nodiscard]] std::size_t get_allocations() const {return allocations_;}
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {return this == &other;}
+
+private:
+    std::pmr::memory_resource* upstream_;
+    std::size_t bytesInUse_ = 0;
+    std::size_t peakBytes_ = 0;
+    std::size_t allocations_ = 0;
+};
+
+
+/// Estimated heap bytes held by a node: its queue / stockpile and its receiver preferences
+struct NodeMemoryUsage
+{
+    ElementID id;
+    std::size_t packages;
+    std::size_t preferences;
+};
+
+struct MemoryUsage
+{
+    std::vector<NodeMemoryUsage> ramps;
+    std::vector<NodeMemoryUsage> workers;
+    std::vector<NodeMemoryUsage> storehouses;
+
+    std::size_t node_collections = 0;   /// Node objects and the ID indices of the factory
+    std::size_t queues = 0;             /// Worker queues
+    std::size_t stockpiles = 0;         /// Storehouse stockpiles
+    std::size_t preferences = 0;        /// Receiver preferences of ramps and workers
+    std::size_t package_ids = 0;        /// Package ID sets (shared by all factories of the process) and the package ledger
+
+    [[nodiscard]] std::size_t total() const {return node_collections + queues + stockpiles + preferences + package_ids;}
+};
+
+class Factory;
+
+/// Can be called between any two turns; O(number of nodes)
+MemoryUsage collect_memory_usage(const Factory& f);
+
+/// Subsystem totals and the nodes holding the most memory (max_nodes = 0 lists all of them)
+void generate_memory_report(const MemoryUsage& usage, std::ostream& os, std::size_t max_nodes = 0);
+
+#endif //SYMULACJASIECI_MEMORY_USAGE_HPP
@@ -5,13 +5,18 @@
 #include "types.hpp"
 #include "helpers.hpp"
 #include "config.hpp"
+#include "statistics.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <map>
 #include <optional>
 #include <utility>
+#include <vector>
 
 
+class PackageLedger;
+
 //#if (defined EXERCISE_ID && EXERCISE_ID != EXERCISE_ID_NODES)
 enum class ReceiverType
 {
@@ -19,6 +24,13 @@ enum class ReceiverType
 };
 //#endif
 
+/// What a sender does when the chosen receiver is full
+enum class BackpressurePolicy
+{
+    RETRY,      /// Keep the package in the sending buffer and try again next turn
+    REROUTE     /// Send it to another receiver with free space (retry if there is none)
+};
+
 class IPackageReceiver
 {
 public:
@@ -33,6 +45,10 @@ public:
     [[nodiscard]] virtual ReceiverType get_receiver_type() const = 0;
 //#endif
 
+    /// Receivers are unbounded unless they override these
+    [[nodiscard]] virtual bool can_receive_package() const {return true;}
+    [[nodiscard]] virtual BackpressurePolicy get_backpressure_policy() const {return BackpressurePolicy::RETRY;}
+
     [[nodiscard]] virtual IPackageStockpile::const_iterator begin() const = 0;
     [[nodiscard]] virtual IPackageStockpile::const_iterator cbegin() const = 0;
     [[nodiscard]] virtual IPackageStockpile::const_iterator end() const = 0;
@@ -52,7 +68,21 @@ public:
     [[nodiscard]] ReceiverType get_receiver_type() const override {return ReceiverType::STOREHOUSE;}
 //#endif
 
-    void receive_package(Package &&p) override {pStockpile_->push(std::move(p));}
+    void receive_package(Package &&p) override;
+
+    /// Arrivals computed in bulk (Factory::advance) - new packages, counted without latency
+    void receive_new_packages(std::size_t count);
+
+    [[nodiscard]] const IPackageStockpile* get_stockpile() const {return pStockpile_.get();}
+    /// Packages received so far - unlike the stockpile size, not capped by RING and kept without statistics
+    [[nodiscard]] std::uint64_t get_received_count() const {return receivedCount_;}
+
+    /// nullptr disables statistics; attaching resets the counters
+    void attach_statistics(StatisticsCollector* collector) {statistics_ = collector; storehouseStatistics_ = {};}
+    [[nodiscard]] const StorehouseStatistics& get_statistics() const {return storehouseStatistics_;}
+
+    /// Arriving packages are retired from the ledger (nullptr: none)
+    void attach_package_ledger(PackageLedger* ledger) {packageLedger_ = ledger;}
 
     [[nodiscard]] IPackageStockpile::const_iterator begin() const override {return pStockpile_->begin();}
     [[nodiscard]] IPackageStockpile::const_iterator cbegin() const override {return pStockpile_->cbegin();}
@@ -62,6 +92,10 @@ public:
 private:
     ElementID id_;
     std::unique_ptr<IPackageStockpile> pStockpile_;
+    std::uint64_t receivedCount_ = 0;
+    StatisticsCollector* statistics_ = nullptr;
+    StorehouseStatistics storehouseStatistics_;
+    PackageLedger* packageLedger_ = nullptr;
 };
 
 
@@ -77,8 +111,20 @@ public:
     void remove_receiver(IPackageReceiver*);
     IPackageReceiver* choose_receiver();
 
+    /// Receiver for a given draw u from [0, 1) - the choice choose_receiver() makes when the generator returns u
+    [[nodiscard]] IPackageReceiver* choose_receiver(double u) const;
+
+    /// Whether draws come from default_probability_generator (they can then be taken from rng directly)
+    [[nodiscard]] bool has_default_generator() const;
+
+    /// Like choose_receiver(), restricted to the receivers which can take a package (nullptr if none)
+    IPackageReceiver* choose_available_receiver();
+
     [[nodiscard]] const preferences_t& get_preferences() const {return preferences_;}
 
+    /// Estimated heap bytes of the map and the flat tables
+    [[nodiscard]] std::size_t get_memory_usage() const;
+
     [[nodiscard]] const_iterator begin() const {return preferences_.cbegin();}
     [[nodiscard]] const_iterator cbegin() const {return preferences_.cbegin();}
     [[nodiscard]] const_iterator end() const {return preferences_.cend();}
@@ -90,6 +136,10 @@ public:
 
 private:
     void reassign_probability();
+
+    /// Flat copy of preferences_ (map order) with running sums of the probabilities
+    std::vector<IPackageReceiver*> receivers_;
+    std::vector<double> cumulative_;
 };
 
 
@@ -99,18 +149,29 @@ public:
     PackageSender() = default;
     PackageSender(PackageSender&&) = default;
 
-    void send_package();
+    /// Returns the receiver which got the package (nullptr if the buffer was empty or the receivers were full)
+    IPackageReceiver* send_package();
+    /// Sends to a receiver already chosen from the preferences, with the same backpressure handling
+    IPackageReceiver* send_package(IPackageReceiver* receiver);
 
     [[nodiscard]] const std::optional<Package>& get_sending_buffer() const {return buffer_;}
 
+    [[nodiscard]] const SenderStatistics& get_sender_statistics() const {return senderStatistics_;}
+
 protected:
     void push_package(Package&&);
 
+    void attach_sender_statistics(StatisticsCollector* collector) {statistics_ = collector; senderStatistics_ = {};}
+
 public:
     ReceiverPreferences receiver_preferences_;
 
+protected:
+    StatisticsCollector* statistics_ = nullptr;
+
 private:
     std::optional<Package> buffer_;
+    SenderStatistics senderStatistics_;
 };
 
 
@@ -119,34 +180,52 @@ class Ramp final: public PackageSender
 public:
     Ramp(ElementID id, TimeOffset di): id_{id}, timeOffset_{di} {push_package(Package());}
 
-    void deliver_goods(Time t);
+    /// Returns the receiver of a delivered package (nullptr if nothing was sent)
+    IPackageReceiver* deliver_goods(Time t) {return deliver_goods(t, t % timeOffset_ == 0);}
+    /// delivery_turn = (t % delivery interval == 0), e.g. precomputed by a CountdownScheduler
+    IPackageReceiver* deliver_goods(Time t, bool delivery_turn);
 
     [[nodiscard]] TimeOffset get_delivery_interval() const {return timeOffset_;}
 
     [[nodiscard]] ElementID get_id() const {return id_;}
 
+    /// nullptr disables statistics; attaching resets the counters
+    void attach_statistics(StatisticsCollector* collector) {attach_sender_statistics(collector); rampStatistics_ = {};}
+    [[nodiscard]] const RampStatistics& get_statistics() const {return rampStatistics_;}
+
+    /// Packages created by deliver_goods get IDs minted by the ledger (nullptr: Package())
+    void attach_package_ledger(PackageLedger* ledger) {packageLedger_ = ledger;}
+
 private:
     ElementID id_;
     TimeOffset timeOffset_;
+    RampStatistics rampStatistics_;
+    PackageLedger* packageLedger_ = nullptr;
 };
 
 
-class Worker final: public PackageSender, public IPackageReceiver
+/// State and turn steps shared by Worker and StaticWorker. Derived provides queue(): IPackageQueue& in Worker,
+/// the concrete StaticPackageQueue in StaticWorker, whose calls are then resolved statically.
+template <typename Derived>
+class WorkerBase: public PackageSender, public IPackageReceiver
 {
 public:
-    Worker(ElementID id, TimeOffset pd, std::unique_ptr<IPackageQueue> q);
-
 //#if (defined EXERCISE_ID && EXERCISE_ID != EXERCISE_ID_NODES)
     [[nodiscard]] ReceiverType get_receiver_type() const override {return ReceiverType::WORKER;}
 //#endif
 
-    [[nodiscard]] IPackageQueue* get_queue() const {return packageQueue_.get();}
-
     void receive_package(Package&&) override;
 
+    [[nodiscard]] bool can_receive_package() const override {return capacity_ == 0 || queue().size() < capacity_;}
+    [[nodiscard]] BackpressurePolicy get_backpressure_policy() const override {return backpressurePolicy_;}
+    [[nodiscard]] std::size_t get_capacity() const {return capacity_;}
+
     [[nodiscard]] ElementID get_id() const override {return id_;}
 
-    void do_work(Time t);
+    /// A finished package waits in the processing buffer while the sending buffer is still occupied
+    void do_work(Time t) {do_work(t, t % timeOffset_ == 0);}
+    /// finishing_turn = (t % processing duration == 0), e.g. precomputed by a CountdownScheduler
+    void do_work(Time t, bool finishing_turn);
 
     [[nodiscard]] TimeOffset get_processing_duration() const {return timeOffset_;}
 
@@ -154,17 +233,121 @@ public:
 
     [[nodiscard]] const std::optional<Package>& get_processing_buffer() const {return processing_buffer_;}
 
-    [[nodiscard]] IPackageStockpile::const_iterator begin() const override {return packageQueue_->begin();}
-    [[nodiscard]] IPackageStockpile::const_iterator cbegin() const override {return packageQueue_->cbegin();}
-    [[nodiscard]] IPackageStockpile::const_iterator end() const override {return packageQueue_->end();}
-    [[nodiscard]] IPackageStockpile::const_iterator cend() const override {return packageQueue_->cend();}
+    /// nullptr disables statistics; attaching resets the counters
+    void attach_statistics(StatisticsCollector* collector) {attach_sender_statistics(collector); workerStatistics_ = {};}
+    [[nodiscard]] const WorkerStatistics& get_statistics() const {return workerStatistics_;}
+
+    [[nodiscard]] IPackageStockpile::const_iterator begin() const override {return queue().begin();}
+    [[nodiscard]] IPackageStockpile::const_iterator cbegin() const override {return queue().cbegin();}
+    [[nodiscard]] IPackageStockpile::const_iterator end() const override {return queue().end();}
+    [[nodiscard]] IPackageStockpile::const_iterator cend() const override {return queue().cend();}
+
+protected:
+    /// capacity = 0 means an unbounded queue
+    WorkerBase(ElementID id, TimeOffset pd, std::size_t capacity, BackpressurePolicy policy):
+        id_{id}, timeOffset_{pd}, capacity_{capacity}, backpressurePolicy_{policy} {}
+
+private:
+    auto& queue() {return static_cast<Derived&>(*this).queue();}
+    const auto& queue() const {return static_cast<const Derived&>(*this).queue();}
 
 private:
     ElementID id_;
     TimeOffset timeOffset_;
     Time processingStartTime_ = 0;
-    std::unique_ptr<IPackageQueue> packageQueue_;
+    std::size_t capacity_;
+    BackpressurePolicy backpressurePolicy_;
     std::optional<Package> processing_buffer_;
+    WorkerStatistics workerStatistics_;
+};
+
+template <typename Derived>
+void WorkerBase<Derived>::receive_package(Package&& package)
+{
+    if (statistics_)
+    {
+        package.set_enqueue_time(statistics_->get_time());
+    }
+    queue().push(std::move(package));
+}
+
+template <typename Derived>
+void WorkerBase<Derived>::do_work(Time t, bool finishing_turn)
+{
+    if (!processing_buffer_.has_value() && !queue().empty())
+    {
+        processing_buffer_.emplace(queue().pop());
+        processingStartTime_ = t;
+        if (statistics_)
+        {
+            workerStatistics_.queue_wait.record(t - processing_buffer_->get_enqueue_time());
+        }
+    }
+    bool busy = processing_buffer_.has_value();
+    if (busy && finishing_turn && !get_sending_buffer().has_value())
+    {
+        push_package(std::move(processing_buffer_.value()));
+        processing_buffer_.reset();
+    }
+
+    if (statistics_)
+    {
+        std::uint64_t queue_length = queue().size();
+        workerStatistics_.queue_length_sum += queue_length;
+        workerStatistics_.queue_length_max = std::max(workerStatistics_.queue_length_max, queue_length);
+        ++(busy ? workerStatistics_.busy_turns : workerStatistics_.idle_turns);
+        if (capacity_ != 0 && queue_length >= capacity_)
+        {
+            ++workerStatistics_.full_turns;
+        }
+    }
+}
+
+
+class Worker final: public WorkerBase<Worker>
+{
+public:
+    /// capacity = 0 means an unbounded queue
+    Worker(ElementID id, TimeOffset pd, std::unique_ptr<IPackageQueue> q,
+           std::size_t capacity = 0, BackpressurePolicy policy = BackpressurePolicy::RETRY);
+
+    [[nodiscard]] IPackageQueue* get_queue() const {return packageQueue_.get();}
+
+private:
+    friend class WorkerBase<Worker>;
+
+    IPackageQueue& queue() {return *packageQueue_;}
+    [[nodiscard]] const IPackageQueue& queue() const {return *packageQueue_;}
+
+private:
+    std::unique_ptr<IPackageQueue> packageQueue_;
+};
+
+
+/// Worker with its queue held by value and the queue discipline fixed at compile time - no pointer
+/// indirection, virtual call or branch per queue operation. Behaves like Worker; it is wired to senders
+/// and receivers by hand (Factory stores only Worker).
+template <PackageQueueType QueueType>
+class StaticWorker final: public WorkerBase<StaticWorker<QueueType>>
+{
+public:
+    using queue_t = StaticPackageQueue<QueueType>;
+
+    /// capacity = 0 means an unbounded queue
+    StaticWorker(ElementID id, TimeOffset pd, std::size_t capacity = 0, BackpressurePolicy policy = BackpressurePolicy::RETRY,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource()):
+        WorkerBase<StaticWorker>(id, pd, capacity, policy), packageQueue_(resource) {}
+
+    [[nodiscard]] const queue_t& get_queue() const {return packageQueue_;}
+
+private:
+    friend class WorkerBase<StaticWorker>;
+
+    queue_t& queue() {return packageQueue_;}
+    [[nodiscard]] const queue_t& queue() const {return packageQueue_;}
+
+private:
+    queue_t packageQueue_;
 };
 
 #endif //SYMULACJASIECI_NODES_HPP
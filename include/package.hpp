@@ -2,16 +2,23 @@
 #define SYMULACJASIECI_PACKAGE_HPP
 
 #include "types.hpp"
+#include <memory_resource>
 #include <set>
 
 // uncomment to disable assert()
+#ifndef NDEBUG
 #define NDEBUG
+#endif
+
+struct PackageHandle;
 
 class Package
 {
 public:
     Package();
     explicit Package(ElementID);
+    /// Takes over the ID of a handle (minted by a PackageLedger or given up by release()); the ID sets are not touched
+    explicit Package(const PackageHandle&);
     Package(Package&&) noexcept;
     ~Package();
 
@@ -19,10 +26,32 @@ public:
 
     [[nodiscard]] ElementID get_id() const{ return ID_;};
 
+    /// Timestamps are stamped by the nodes only while statistics are enabled (0 otherwise)
+    [[nodiscard]] Time get_creation_time() const {return creationTime_;}
+    [[nodiscard]] Time get_enqueue_time() const {return enqueueTime_;}
+
+    void set_creation_time(Time t) {creationTime_ = t;}
+    void set_enqueue_time(Time t) {enqueueTime_ = t;}
+
+    /// Hands the ID over to a handle - the package is left empty (ID 0) and releases nothing when destroyed
+    PackageHandle release();
+
+    /// Takes the lowest free ID / gives an ID back, as Package() and ~Package() do - for IDs held
+    /// outside Package objects (PackageLedger, HandleStockpile)
+    static ElementID acquire_id();
+    static void release_id(ElementID id);
+
+    /// Estimated heap bytes of the ID sets (shared by all packages of the process)
+    [[nodiscard]] static std::size_t get_id_sets_memory_usage();
+
 private:
     ElementID ID_;
-    static inline std::set<ElementID> assignedIDs_{};
-    static inline std::set<ElementID> freedIDs_{};
+    Time creationTime_ = 0;     /// Turn in which a ramp created the package
+    Time enqueueTime_ = 0;      /// Turn in which the package entered the current worker queue
+    /// ID sets are shared by all factories of the process, so they use their own pool instead of the global heap
+    static inline std::pmr::unsynchronized_pool_resource idPool_{};
+    static inline std::pmr::set<ElementID> assignedIDs_{&idPool_};
+    static inline std::pmr::set<ElementID> freedIDs_{&idPool_};
 };
 
 
@@ -0,0 +1,131 @@
+#ifndef SYMULACJASIECI_PACKAGE_HANDLE_HPP
+#define SYMULACJASIECI_PACKAGE_HANDLE_HPP
+
+#include "types.hpp"
+#include "package.hpp"
+#include "storage_types.hpp"
+
+#include <cstddef>
+#include <list>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+/// Package as a plain value: copying or moving it does not touch any ID bookkeeping.
+/// IDs are minted and retired explicitly by a PackageLedger, or taken over from a Package (Package::release).
+struct PackageHandle
+{
+    ElementID id = 0;           /// 0 = no package
+    Time creation_time = 0;
+    Time enqueue_time = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<PackageHandle>, "PackageHandle has to be relocatable with memcpy");
+
+
+/// Packages in flight in a factory: a ramp mints the ID of every package it creates, a storehouse retires it
+/// on arrival and node removal retires the packages the node still holds. Packages created without the ledger
+/// (before it was enabled, or in bulk) are adopted. IDs come from the process-wide ID set of Package, so they
+/// never collide with other packages.
+class PackageLedger
+{
+public:
+    /// Takes the lowest free ID (Package::acquire_id)
+    PackageHandle mint(Time creation_time = 0);
+
+    /// Frees the ID of a handle not held by any Package.
+    /// Throws std::logic_error if the package is not live (already retired or minted by another ledger)
+    void retire(const PackageHandle& package);
+    /// Counts an existing package as in flight; no-op if it already is
+    void adopt(const Package& package) {mark_live(package.get_id());}
+    /// The package left the factory - its ID stays taken until the Package object is destroyed.
+    /// Throws std::logic_error if the package is not live (neither minted nor adopted by this ledger)
+    void retire(const Package& package);
+
+    [[nodiscard]] bool is_live(ElementID id) const {return id != 0 && id <= live_.size() && live_[id - 1];}
+    [[nodiscard]] std::size_t live_count() const {return liveCount_;}
+
+    /// Estimated heap bytes of the live flags
+    [[nodiscard]] std::size_t get_memory_usage() const {return live_.capacity() / 8;}
+
+private:
+    void mark_live(ElementID id);
+
+private:
+    std::vector<bool> live_;    /// Index id - 1
+    std::size_t liveCount_ = 0;
+};
+
+
+/// FIFO/LIFO queue of handles in a ring buffer. Growing, bulk pushes and bulk pops copy whole
+/// ranges with memcpy.
+class PackageHandleQueue
+{
+public:
+    /// The buffer is allocated from the given memory resource, which has to outlive the queue
+    explicit PackageHandleQueue(PackageQueueType packageQueueType, std::size_t initial_capacity = 16,
+                                std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void push(const PackageHandle& package);
+    PackageHandle pop();
+
+    /// Appends count handles in order
+    void push_bulk(const PackageHandle* packages, std::size_t count);
+    /// Writes up to n handles to out, in pop order; returns how many were written
+    std::size_t pop_n(std::size_t n, PackageHandle* out);
+
+    [[nodiscard]] bool empty() const {return size_ == 0;}
+    [[nodiscard]] std::size_t size() const {return size_;}
+    [[nodiscard]] std::size_t capacity() const {return capacity_;}
+    [[nodiscard]] PackageQueueType get_queue_type() const {return packageQueueType_;}
+
+    /// i-th handle in arrival order (0 = oldest)
+    [[nodiscard]] const PackageHandle& operator[](std::size_t i) const {return buffer_[(head_ + i) & (capacity_ - 1)];}
+
+private:
+    void reserve(std::size_t capacity);
+    /// Copies count handles starting at logical position first into out
+    void copy_out(std::size_t first, std::size_t count, PackageHandle* out) const;
+
+private:
+    std::pmr::vector<PackageHandle> buffer_;
+    std::size_t capacity_ = 0;  /// Power of two
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+    PackageQueueType packageQueueType_;
+};
+
+
+/// Storehouse stockpile keeping the arrived packages as handles in a ring buffer (arrival order) - no list
+/// node per package, growing copies whole ranges with memcpy. It holds their IDs until it is destroyed.
+/// Iteration yields nothing (as for CountingStockpile); the packages are reachable through get_handles().
+class HandleStockpile final: public IPackageStockpile
+{
+public:
+    explicit HandleStockpile(std::pmr::memory_resource* resource = std::pmr::get_default_resource()):
+        handles_(PackageQueueType::FIFO, 16, resource) {}
+    ~HandleStockpile() override;
+
+    HandleStockpile(const HandleStockpile&) = delete;
+    HandleStockpile& operator=(const HandleStockpile&) = delete;
+
+    void push(Package&& package) override {handles_.push(package.release());}
+    void push_bulk(std::vector<Package>&& packages) override;
+    void push_new(std::size_t count) override;
+    [[nodiscard]] std::size_t get_memory_usage() const override {return handles_.capacity() * sizeof(PackageHandle);}
+    [[nodiscard]] bool empty() const override {return handles_.empty();}
+    [[nodiscard]] std::size_t size() const override {return handles_.size();}
+
+    [[nodiscard]] const PackageHandleQueue& get_handles() const {return handles_;}
+
+    [[nodiscard]] const_iterator begin() const override {return empty_.cbegin();}
+    [[nodiscard]] const_iterator cbegin() const override {return empty_.cbegin();}
+    [[nodiscard]] const_iterator end() const override {return empty_.cend();}
+    [[nodiscard]] const_iterator cend() const override {return empty_.cend();}
+
+private:
+    PackageHandleQueue handles_;
+    std::pmr::list<Package> empty_;
+};
+
+#endif //SYMULACJASIECI_PACKAGE_HANDLE_HPP
@@ -7,4 +7,29 @@ void generate_structure_report(const Factory& f, std::ostream& os);
 
 void generate_simulation_turn_report(const Factory& f, std::ostream& os, Time t);
 
+/// Formats the turn into the writer's buffer and flushes once, at the end of the turn.
+/// Keep one writer for the whole run to reuse its buffer.
+void generate_simulation_turn_report(const Factory& f, BufferedWriter& writer, Time t);
+
+/// Turn report limited to the workers and storehouses recorded by the factory's change tracking
+/// (same node blocks as the full report, ordered by ID). Does not clear the recorded changes.
+void generate_simulation_turn_delta_report(const Factory& f, BufferedWriter& writer, Time t);
+
+
+/// Report function for simulate(): a full report (keyframe) every keyframe_interval turns,
+/// delta reports in between. Applying the deltas to the last keyframe gives the full state.
+/// Enables change tracking on the factory at the first report.
+class DeltaTurnReporter
+{
+public:
+    explicit DeltaTurnReporter(std::ostream& os, TimeOffset keyframe_interval = 100);
+
+    void operator()(Factory& f, Time t);
+
+private:
+    BufferedWriter writer_;
+    TimeOffset keyframeInterval_;
+    TimeOffset turnsSinceKeyframe_ = 0;
+};
+
 #endif //SYMULACJASIECI_REPORTS_HPP
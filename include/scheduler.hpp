@@ -0,0 +1,49 @@
+#ifndef SYMULACJASIECI_SCHEDULER_HPP
+#define SYMULACJASIECI_SCHEDULER_HPP
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class SchedulerKernel
+{
+    AUTO,   /// Best kernel supported by the CPU
+    SCALAR, SSE2, AVX2
+};
+
+/// Fire turns of periodic nodes (t % period == 0) kept as countdowns in a contiguous array.
+/// Every turn all countdowns are decremented and tested at once (SSE2/AVX2 when available),
+/// without a division per node. Consecutive turns only step the countdowns; any other
+/// turn (first call, time jump) resynchronises them from the modulo.
+class CountdownScheduler
+{
+public:
+    /// Throws std::invalid_argument if the requested kernel is not supported by the CPU
+    explicit CountdownScheduler(SchedulerKernel kernel = SchedulerKernel::AUTO);
+
+    /// Periods must be positive
+    void set_periods(const std::vector<TimeOffset>& periods);
+
+    /// Indices (ascending) of the nodes for which t is a fire turn
+    const std::vector<std::uint32_t>& advance(Time t);
+
+    [[nodiscard]] std::size_t size() const {return periods_.size();}
+    [[nodiscard]] SchedulerKernel get_kernel() const {return kernel_;}
+
+    static bool is_supported(SchedulerKernel kernel);
+
+private:
+    void resync(Time t);
+
+private:
+    SchedulerKernel kernel_;
+    std::vector<std::int32_t> periods_;
+    std::vector<std::int32_t> countdowns_;  /// Turns to the next fire, counting the coming turn as 1
+    std::vector<std::uint32_t> fired_;
+    Time last_ = 0;
+    bool synced_ = false;
+};
+
+#endif //SYMULACJASIECI_SCHEDULER_HPP
@@ -0,0 +1,48 @@
+#ifndef SYMULACJASIECI_SERVER_HPP
+#define SYMULACJASIECI_SERVER_HPP
+
+#include "factory.hpp"
+#include "types.hpp"
+
+#include <optional>
+#include <ostream>
+#include <string>
+
+/// A factory kept in memory between text commands, one command per line:
+///   SIMULATE <turns>        run the next turns (from the current turn on; the last turn has to fit in Time)
+///   PATCH ... END           apply the structure patch given on the lines in between (see apply_factory_patch)
+///   STATISTICS [ON|OFF]     statistics report, or enable / disable statistics (enabling resets the counters)
+///   REPORT                  turn report of the current state
+///   FLOW                    analytical flow estimate
+///   MEMORY                  memory held by the nodes and subsystems
+///   SAVE [path]             save the structure to a file, or into the response
+///   SHUTDOWN                stop serving
+/// Every response ends with a line "OK" or "ERROR <message>"; the session stays usable after an error.
+class SimulationSession
+{
+public:
+    explicit SimulationSession(Factory&& factory): factory_{std::move(factory)} {}
+
+    /// Returns false after SHUTDOWN
+    bool handle_line(const std::string& line, std::ostream& out);
+
+    [[nodiscard]] const Factory& get_factory() const {return factory_;}
+    [[nodiscard]] Time get_time() const {return time_;}
+
+private:
+    void handle_command(const std::string& command, const std::string& arguments, std::ostream& out);
+
+private:
+    Factory factory_;
+    Time time_ = 0;
+    std::optional<std::string> patch_;  /// Lines of an unfinished PATCH command
+};
+
+/// Serves the session on a Unix domain socket, one client at a time, until SHUTDOWN.
+/// Besides the session commands the server handles
+///   FORK <socket path>      copy of the whole process (factory state, random generator) serving on another socket
+///   QUIT                    close the connection
+/// Throws std::system_error on socket errors and std::invalid_argument if socket_path exists and is not a socket.
+void serve_session(SimulationSession& session, const std::string& socket_path);
+
+#endif //SYMULACJASIECI_SERVER_HPP
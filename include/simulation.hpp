@@ -0,0 +1,37 @@
+#ifndef SYMULACJASIECI_SIMULATION_HPP
+#define SYMULACJASIECI_SIMULATION_HPP
+
+#include "factory.hpp"
+#include "types.hpp"
+#include "statistics.hpp"
+#include "convergence.hpp"
+
+#include <functional>
+#include <optional>
+
+struct SimulationOptions
+{
+    /// Stop before d turns once the monitor detects steady state or divergence
+    std::optional<ConvergenceParameters> convergence;
+
+    /// Turns per Factory::advance call (0 = turn by turn); rf is then called only after each block
+    /// and the last turn. Cannot be combined with convergence detection, which observes every turn.
+    TimeOffset skip_ahead = 0;
+};
+
+struct SimulationSummary
+{
+    Time turns = 0;                                 /// Turns actually simulated
+    StopReason stop_reason = StopReason::COMPLETED;
+    ElementID diverging_worker = 0;                 /// Set if stop_reason is DIVERGED
+    std::optional<StatisticsSummary> statistics;    /// Set if statistics are enabled on the factory
+};
+
+/// Runs turns 1..d (deliveries, package passing, work) and calls rf after every turn.
+/// Throws std::logic_error if the factory is not consistent.
+SimulationSummary simulate(Factory& f, TimeOffset d, std::function<void(Factory&, Time)> rf);
+
+/// Throws std::invalid_argument if skip-ahead is negative or combined with convergence detection
+SimulationSummary simulate(Factory& f, TimeOffset d, std::function<void(Factory&, Time)> rf, const SimulationOptions& options);
+
+#endif //SYMULACJASIECI_SIMULATION_HPP
@@ -0,0 +1,138 @@
+#ifndef SYMULACJASIECI_STATISTICS_HPP
+#define SYMULACJASIECI_STATISTICS_HPP
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/// Histogram of non-negative durations (in turns) with logarithmic buckets: exact below 16,
+/// then 8 buckets per power of two (relative error below 12.5%). At most 240 buckets per histogram.
+class LatencyHistogram
+{
+public:
+    void record(Time value);
+
+    [[nodiscard]] std::uint64_t count() const {return count_;}
+    [[nodiscard]] Time max() const {return max_;}
+
+    /// Upper bound of the bucket holding the given quantile (0 when empty), e.g. percentile(0.99)
+    [[nodiscard]] Time percentile(double quantile) const;
+
+private:
+    static constexpr unsigned sub_bucket_bits = 3;
+    static constexpr unsigned sub_buckets = 1U << sub_bucket_bits;
+
+    static std::size_t bucket_index(std::uint32_t value);
+    static std::uint32_t bucket_upper_bound(std::size_t index);
+
+    std::vector<std::uint64_t> buckets_;    /// Grows up to the highest bucket used
+    std::uint64_t count_ = 0;
+    Time max_ = 0;
+};
+
+
+/// Per-node counters, updated in O(1) by the nodes while statistics are enabled
+
+struct SenderStatistics
+{
+    std::uint64_t packages_sent = 0;
+    std::uint64_t blocked_sends = 0;        /// Attempts which found the chosen receiver full
+    std::uint64_t rerouted_packages = 0;    /// Packages sent to another receiver because of that
+};
+
+struct RampStatistics
+{
+    std::uint64_t deliveries = 0;   /// Packages created by the ramp
+};
+
+struct WorkerStatistics
+{
+    std::uint64_t busy_turns = 0;   /// Turns with a package in the processing buffer
+    std::uint64_t idle_turns = 0;
+    std::uint64_t queue_length_sum = 0;
+    std::uint64_t queue_length_max = 0;
+    std::uint64_t full_turns = 0;   /// Turns ending with a bounded queue at capacity
+    LatencyHistogram queue_wait;    /// Turns between entering the queue and processing start
+};
+
+struct StorehouseStatistics
+{
+    std::uint64_t packages_received = 0;
+    LatencyHistogram latency;       /// Turns between creation at a ramp and arrival
+};
+
+
+/// Shared state of the statistics of one factory; nodes hold a pointer to it (nullptr = disabled)
+class StatisticsCollector
+{
+public:
+    void start_turn(Time t) {time_ = t; ++turns_;}
+
+    [[nodiscard]] Time get_time() const {return time_;}
+    [[nodiscard]] Time get_turns() const {return turns_;}
+
+private:
+    Time time_ = 0;
+    Time turns_ = 0;
+};
+
+
+struct RampSummary
+{
+    ElementID id;
+    std::uint64_t deliveries;
+    std::uint64_t packages_sent;
+    std::uint64_t blocked_sends;
+    std::uint64_t rerouted_packages;
+};
+
+struct LatencySummary
+{
+    Time p50;
+    Time p99;
+    Time p999;
+    Time max;
+};
+
+struct WorkerSummary
+{
+    ElementID id;
+    std::uint64_t busy_turns;
+    std::uint64_t idle_turns;
+    double utilization;
+    double queue_length_mean;
+    std::uint64_t queue_length_max;
+    std::uint64_t packages_sent;
+    std::uint64_t blocked_sends;
+    std::uint64_t rerouted_packages;
+    std::uint64_t full_turns;
+    LatencySummary queue_wait;
+};
+
+struct StorehouseSummary
+{
+    ElementID id;
+    std::uint64_t packages_received;
+    double throughput;  /// Packages per turn
+    LatencySummary latency;
+};
+
+struct StatisticsSummary
+{
+    Time turns = 0;
+    std::vector<RampSummary> ramps;
+    std::vector<WorkerSummary> workers;
+    std::vector<StorehouseSummary> storehouses;
+};
+
+class Factory;
+
+/// Requires statistics enabled on the factory (Factory::enable_statistics)
+StatisticsSummary collect_statistics(const Factory& f);
+
+void generate_statistics_report(const StatisticsSummary& summary, std::ostream& os);
+
+#endif //SYMULACJASIECI_STATISTICS_HPP
@@ -2,7 +2,11 @@
 #define SYMULACJASIECI_STORAGE_TYPES_HPP
 
 #include <list>
+#include <memory_resource>
+#include <vector>
 #include "package.hpp"
+#include "instrumentation.hpp"
+#include "memory_usage.hpp"
 
 enum class PackageQueueType
 {
@@ -13,7 +17,7 @@ enum class PackageQueueType
 class IPackageStockpile
 {
 public:
-    using const_iterator = std::list<Package>::const_iterator;
+    using const_iterator = std::pmr::list<Package>::const_iterator;
 
     virtual ~IPackageStockpile() = default;
 
@@ -21,6 +25,15 @@ public:
     virtual bool empty() const = 0;
     virtual std::size_t size() const = 0;
 
+    /// Pushes the packages in order with a single call; leaves the vector empty
+    virtual void push_bulk(std::vector<Package>&& packages);
+
+    /// Pushes count newly created packages (e.g. arrivals computed in bulk)
+    virtual void push_new(std::size_t count);
+
+    /// Estimated heap bytes held by the packages (one list node each unless overridden)
+    [[nodiscard]] virtual std::size_t get_memory_usage() const {return size() * list_node_bytes<Package>;}
+
     virtual const_iterator begin() const = 0;
     virtual const_iterator cbegin() const = 0;
     virtual const_iterator end() const = 0;
@@ -34,13 +47,21 @@ public:
     virtual ~IPackageQueue() = default;
     virtual Package pop() = 0;
     [[nodiscard]] virtual PackageQueueType get_queue_type() const = 0;
+
+    /// Appends up to n packages to out, in pop order; returns how many were moved
+    virtual std::size_t pop_n(std::size_t n, std::vector<Package>& out);
+
+    /// Moves all packages to target, in pop order; returns how many were moved
+    virtual std::size_t drain_into(IPackageStockpile& target);
 };
 
 
 class PackageQueue final: public IPackageQueue
 {
 public:
-    explicit PackageQueue(PackageQueueType packageQueueType): packageQueueType_{packageQueueType} {}
+    /// List nodes are allocated from the given memory resource, which has to outlive the queue
+    explicit PackageQueue(PackageQueueType packageQueueType, std::pmr::memory_resource* resource = std::pmr::get_default_resource()):
+        packageList_(resource), packageQueueType_{packageQueueType} {}
 
     void push(Package&&) override;
     [[nodiscard]] bool empty() const override {return packageList_.empty();}
@@ -48,14 +69,109 @@ public:
     Package pop() override;
     [[nodiscard]] PackageQueueType get_queue_type() const override {return packageQueueType_;}
 
+    void push_bulk(std::vector<Package>&& packages) override;
+    std::size_t pop_n(std::size_t n, std::vector<Package>& out) override;
+    /// Into another PackageQueue with the same memory resource the list nodes are spliced, without moving the packages
+    std::size_t drain_into(IPackageStockpile& target) override;
+
     [[nodiscard]] const_iterator begin() const override {return packageList_.cbegin();}
     [[nodiscard]] const_iterator cbegin() const override {return packageList_.cbegin();}
     [[nodiscard]] const_iterator end() const override {return packageList_.cend();}
     [[nodiscard]] const_iterator cend() const override {return packageList_.cend();}
 
 private:
-    std::list<Package> packageList_;
+    std::pmr::list<Package> packageList_;
     PackageQueueType packageQueueType_;
 };
 
+
+/// Queue with the discipline fixed at compile time. Through the concrete type (e.g. held by value in
+/// StaticWorker) calls are resolved statically and pop() has no branch; it is still an IPackageQueue.
+template <PackageQueueType QueueType>
+class StaticPackageQueue final: public IPackageQueue
+{
+public:
+    explicit StaticPackageQueue(std::pmr::memory_resource* resource = std::pmr::get_default_resource()): packageList_(resource) {}
+
+    void push(Package&& package) override {INSTRUMENT_COUNT(QUEUE_PUSHES, 1); packageList_.emplace_back(std::move(package));}
+    [[nodiscard]] bool empty() const override {return packageList_.empty();}
+    [[nodiscard]] std::size_t size() const override {return packageList_.size();}
+    [[nodiscard]] PackageQueueType get_queue_type() const override {return QueueType;}
+
+    Package pop() override
+    {
+        INSTRUMENT_COUNT(QUEUE_POPS, 1);
+        if constexpr (QueueType == PackageQueueType::FIFO)
+        {
+            Package package(std::move(packageList_.front()));
+            packageList_.pop_front();
+            return package;
+        }
+        else
+        {
+            Package package(std::move(packageList_.back()));
+            packageList_.pop_back();
+            return package;
+        }
+    }
+
+    [[nodiscard]] const_iterator begin() const override {return packageList_.cbegin();}
+    [[nodiscard]] const_iterator cbegin() const override {return packageList_.cbegin();}
+    [[nodiscard]] const_iterator end() const override {return packageList_.cend();}
+    [[nodiscard]] const_iterator cend() const override {return packageList_.cend();}
+
+private:
+    std::pmr::list<Package> packageList_;
+};
+
+using StaticFifoQueue = StaticPackageQueue<PackageQueueType::FIFO>;
+using StaticLifoQueue = StaticPackageQueue<PackageQueueType::LIFO>;
+
+
+/// Stockpile which only counts the packages - they are destroyed (and their IDs released) on arrival.
+/// size() is the number of received packages, iteration yields nothing.
+class CountingStockpile final: public IPackageStockpile
+{
+public:
+    void push(Package&&) override {++count_;}
+    void push_bulk(std::vector<Package>&& packages) override {count_ += packages.size(); packages.clear();}
+    void push_new(std::size_t count) override {count_ += count;}
+    [[nodiscard]] std::size_t get_memory_usage() const override {return 0;}
+    [[nodiscard]] bool empty() const override {return count_ == 0;}
+    [[nodiscard]] std::size_t size() const override {return count_;}
+
+    [[nodiscard]] const_iterator begin() const override {return empty_.cbegin();}
+    [[nodiscard]] const_iterator cbegin() const override {return empty_.cbegin();}
+    [[nodiscard]] const_iterator end() const override {return empty_.cend();}
+    [[nodiscard]] const_iterator cend() const override {return empty_.cend();}
+
+private:
+    std::size_t count_ = 0;
+    std::pmr::list<Package> empty_;
+};
+
+
+/// Stockpile keeping only the last `capacity` packages (oldest first); older ones are destroyed.
+/// Once full, the list nodes are reused, so pushing does not allocate.
+class RingStockpile final: public IPackageStockpile
+{
+public:
+    explicit RingStockpile(std::size_t capacity, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void push(Package&&) override;
+    [[nodiscard]] bool empty() const override {return packageList_.empty();}
+    [[nodiscard]] std::size_t size() const override {return packageList_.size();}
+
+    [[nodiscard]] std::size_t get_capacity() const {return capacity_;}
+
+    [[nodiscard]] const_iterator begin() const override {return packageList_.cbegin();}
+    [[nodiscard]] const_iterator cbegin() const override {return packageList_.cbegin();}
+    [[nodiscard]] const_iterator end() const override {return packageList_.cend();}
+    [[nodiscard]] const_iterator cend() const override {return packageList_.cend();}
+
+private:
+    std::pmr::list<Package> packageList_;
+    std::size_t capacity_;
+};
+
 #endif //SYMULACJASIECI_STORAGE_TYPES_HPP
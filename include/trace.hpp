@@ -0,0 +1,85 @@
+#ifndef SYMULACJASIECI_TRACE_HPP
+#define SYMULACJASIECI_TRACE_HPP
+
+#include "factory.hpp"
+#include "buffered_writer.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// Binary columnar trace of a simulation (native byte order):
+///   header: "SSTRACE1", uint32 worker count W, uint32 storehouse count S,
+///           uint64 worker IDs[W], uint64 storehouse IDs[S]
+///   chunks: uint32 turn count n, int32 times[n],
+///           uint32 queue lengths[n*W], uint64 processing buffer IDs[n*W], uint64 sending buffer IDs[n*W],
+///           uint64 stock counts[n*S]
+/// Each column holds the values of consecutive turns, W (or S) values per turn, nodes in factory order.
+/// Package ID 0 means an empty buffer.
+struct TraceChunk
+{
+    std::vector<Time> times;
+    std::vector<std::uint32_t> queue_lengths;
+    std::vector<ElementID> processing_buffers;
+    std::vector<ElementID> sending_buffers;
+    std::vector<std::uint64_t> stock_counts;
+
+    [[nodiscard]] std::size_t turns() const {return times.size();}
+    void clear();
+};
+
+
+/// Report function for simulate() recording one row per turn; the set of nodes must not change during the run
+class TraceWriter
+{
+public:
+    explicit TraceWriter(const std::string& path, std::size_t chunk_turns = 1024);
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    ~TraceWriter();
+
+    void operator()(Factory& f, Time t);
+
+    /// Writes the pending chunk
+    void flush();
+
+private:
+    template<typename T>
+    void write_column(const std::vector<T>& column) {writer_.write(column.data(), column.size() * sizeof(T));}
+
+private:
+    BufferedWriter writer_;
+    std::size_t chunkTurns_;
+    bool headerWritten_ = false;
+    std::uint32_t workerCount_ = 0;
+    std::uint32_t storehouseCount_ = 0;
+    TraceChunk chunk_;
+};
+
+
+class TraceReader
+{
+public:
+    /// Throws std::runtime_error if the file is not a trace
+    explicit TraceReader(const std::string& path);
+
+    [[nodiscard]] const std::vector<ElementID>& get_worker_ids() const {return workerIds_;}
+    [[nodiscard]] const std::vector<ElementID>& get_storehouse_ids() const {return storehouseIds_;}
+
+    /// Reads the next chunk, returns false at the end of the trace
+    bool read_chunk(TraceChunk& chunk);
+
+private:
+    template<typename T>
+    void read_column(std::vector<T>& column, std::size_t size);
+
+private:
+    std::ifstream is_;
+    std::vector<ElementID> workerIds_;
+    std::vector<ElementID> storehouseIds_;
+};
+
+#endif //SYMULACJASIECI_TRACE_HPP
@@ -1,7 +1,315 @@
+#include "async_reports.hpp"
+#include "factory.hpp"
+#include "flow.hpp"
+#include "helpers.hpp"
+#include "instrumentation.hpp"
+#include "memory_usage.hpp"
+#include "reports.hpp"
+#include "server.hpp"
+#include "simulation.hpp"
+#include "statistics.hpp"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " --structure PATH [options]\n"
+              << "  --structure PATH          factory structure file\n"
+              << "  --turns N                 number of turns (default 100)\n"
+              << "  --engine NAME             step, countdown, batched or skip-ahead (default step)\n"
+              << "  --threads N               1 = reports written by the simulation thread,\n"
+              << "                            2 = by a background writer thread (default 1)\n"
+              << "  --seed N                  seed of the receiver draws (default: random)\n"
+              << "  --structure-report PATH   write the structure report\n"
+              << "  --turn-report PATH        write turn reports\n"
+              << "  --report-interval N       turns between turn reports (default 1)\n"
+              << "  --statistics PATH         collect statistics and write the statistics report\n"
+              << "  --flow-report PATH        write the analytical flow estimate\n"
+              << "  --convergence             stop at steady state or divergence\n"
+              << "  --memory-report PATH      write the memory held by every node at the end of the run\n"
+              << "  --chrome-trace PATH       write phase timings and counters as a Chrome trace\n"
+              << "                            (needs a build with -DSYMULACJASIECI_INSTRUMENTATION=ON)\n"
+              << "  --serve SOCKET            keep the factory in memory and serve commands on a Unix socket\n"
+              << "                            instead of simulating (see server.hpp)\n";
+}
+
+struct DriverOptions
+{
+    std::string structure;
+    TimeOffset turns = 100;
+    std::string engine = "step";
+    int threads = 1;
+    std::optional<std::uint64_t> seed;
+    std::string structure_report;
+    std::string turn_report;
+    TimeOffset report_interval = 1;
+    std::string statistics;
+    std::string flow_report;
+    bool convergence = false;
+    std::string serve;
+    std::string chrome_trace;
+    std::string memory_report;
+};
+
+DriverOptions parse_options(int argc, char* argv[])
+{
+    DriverOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        if (option == "--convergence")
+        {
+            options.convergence = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument("Missing value for " + option);
+        }
+        std::string value = argv[++i];
+
+        if (option == "--structure") {options.structure = value;}
+        else if (option == "--turns") {options.turns = std::stoi(value);}
+        else if (option == "--engine") {options.engine = value;}
+        else if (option == "--threads") {options.threads = std::stoi(value);}
+        else if (option == "--seed") {options.seed = std::stoull(value);}
+        else if (option == "--structure-report") {options.structure_report = value;}
+        else if (option == "--turn-report") {options.turn_report = value;}
+        else if (option == "--report-interval") {options.report_interval = std::stoi(value);}
+        else if (option == "--statistics") {options.statistics = value;}
+        else if (option == "--flow-report") {options.flow_report = value;}
+        else if (option == "--serve") {options.serve = value;}
+        else if (option == "--chrome-trace") {options.chrome_trace = value;}
+        else if (option == "--memory-report") {options.memory_report = value;}
+        else {throw std::invalid_argument("Unknown option " + option);}
+    }
+
+    if (options.structure.empty())
+    {
+        throw std::invalid_argument("Missing --structure");
+    }
+    if (options.turns < 0 || options.report_interval < 1)
+    {
+        throw std::invalid_argument("Turns must not be negative and the report interval must be positive");
+    }
+    if (options.engine != "step" && options.engine != "countdown" && options.engine != "batched" && options.engine != "skip-ahead")
+    {
+        throw std::invalid_argument("Unknown engine " + options.engine);
+    }
+    /// The engines are single-threaded; the only work which can run next to the simulation is report writing
+    if (options.threads != 1 && options.threads != 2)
+    {
+        throw std::invalid_argument("Only 1 or 2 threads are supported");
+    }
+    if (options.engine == "skip-ahead" && options.convergence)
+    {
+        throw std::invalid_argument("Skip-ahead cannot be combined with --convergence");
+    }
+    return options;
+}
+
+std::ofstream open_output(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    return file;
+}
+
+const char* stop_reason_name(StopReason reason)
+{
+    switch (reason)
+    {
+        case StopReason::COMPLETED: return "completed";
+        case StopReason::STEADY_STATE: return "steady state";
+        case StopReason::DIVERGED: return "diverged";
+    }
+    return "";
+}
 
-int main()
+int run(const DriverOptions& options)
 {
-    std::cout << "Hello, World!" << std::endl;
+    using clock = std::chrono::steady_clock;
+
+    if (!options.chrome_trace.empty())
+    {
+        if (!instrumentation_compiled_in)
+        {
+            std::cerr << "Built without SYMULACJASIECI_INSTRUMENTATION - the trace will hold no events\n";
+        }
+        instrumentation().enable(true);
+    }
+
+    auto load_start = clock::now();
+    std::ifstream structure_file(options.structure);
+    if (!structure_file)
+    {
+        throw std::runtime_error("Cannot open " + options.structure);
+    }
+    /// Queues and stockpiles allocate through it - the real bytes next to the estimates in the summary
+    CountingMemoryResource factory_resource;
+    Factory factory = load_factory_structure(structure_file, &factory_resource);
+    if (!factory.is_consistent())
+    {
+        std::cerr << "Factory structure " << options.structure << " is not consistent\n";
+        return 2;
+    }
+    auto load_end = clock::now();
+
+    if (options.seed)
+    {
+        rng.seed(*options.seed);
+    }
+    if (!options.structure_report.empty())
+    {
+        std::ofstream os = open_output(options.structure_report);
+        generate_structure_report(factory, os);
+    }
+    if (!options.flow_report.empty())
+    {
+        std::ofstream os = open_output(options.flow_report);
+        generate_flow_report(estimate_flow(factory), os);
+    }
+
+    if (!options.serve.empty())
+    {
+        SimulationSession session(std::move(factory));
+        std::cout << "Serving " << options.structure << " on " << options.serve << std::endl;
+        serve_session(session, options.serve);
+        return 0;
+    }
+
+    factory.enable_statistics(!options.statistics.empty());
+    factory.enable_countdown_scheduling(options.engine == "countdown");
+    factory.enable_batched_passing(options.engine == "batched");
+
+    SimulationOptions simulation_options;
+    if (options.convergence)
+    {
+        simulation_options.convergence = ConvergenceParameters();
+    }
+    if (options.engine == "skip-ahead")
+    {
+        simulation_options.skip_ahead = options.turn_report.empty() ? std::max<TimeOffset>(options.turns, 1) : options.report_interval;
+    }
+
+    std::unique_ptr<BufferedWriter> turn_writer;
+    std::unique_ptr<AsyncReportWriter> async_writer;
+    std::function<void(Factory&, Time)> report = [](Factory&, Time) {};
+    if (!options.turn_report.empty() && options.threads == 2)
+    {
+        async_writer = std::make_unique<AsyncReportWriter>(options.turn_report);
+        report = [&async_writer, &options](Factory& f, Time t)
+        {
+            if (t % options.report_interval == 0) {(*async_writer)(f, t);}
+        };
+    }
+    else if (!options.turn_report.empty())
+    {
+        turn_writer = std::make_unique<BufferedWriter>(options.turn_report);
+        report = [&turn_writer, &options](Factory& f, Time t)
+        {
+            if (t % options.report_interval == 0) {generate_simulation_turn_report(f, *turn_writer, t);}
+        };
+    }
+
+    auto simulation_start = clock::now();
+    SimulationSummary summary = simulate(factory, options.turns, report, simulation_options);
+    if (async_writer)
+    {
+        async_writer->close();
+    }
+    auto simulation_end = clock::now();
+
+    if (summary.statistics)
+    {
+        std::ofstream os = open_output(options.statistics);
+        generate_statistics_report(*summary.statistics, os);
+    }
+    if (!options.chrome_trace.empty())
+    {
+        instrumentation().enable(false);
+        std::ofstream os = open_output(options.chrome_trace);
+        instrumentation().write_chrome_trace(os);
+        instrumentation().write_summary(std::cout);
+    }
+
+    MemoryUsage memory = collect_memory_usage(factory);
+    if (!options.memory_report.empty())
+    {
+        std::ofstream os = open_output(options.memory_report);
+        generate_memory_report(memory, os);
+    }
+
+    std::chrono::duration<double> load_time = load_end - load_start;
+    std::chrono::duration<double> simulation_time = simulation_end - simulation_start;
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::cout << "Structure: " << options.structure << "\n";
+    std::cout << "Engine: " << options.engine << ", threads: " << options.threads << "\n";
+    std::cout << "Turns: " << summary.turns << " (" << stop_reason_name(summary.stop_reason);
+    if (summary.stop_reason == StopReason::DIVERGED)
+    {
+        std::cout << " at worker #" << summary.diverging_worker;
+    }
+    std::cout << ")\n";
+    std::cout << "Load time: " << load_time.count() * 1000 << " ms\n";
+    std::cout << "Simulation time: " << simulation_time.count() * 1000 << " ms";
+    if (simulation_time.count() > 0)
+    {
+        std::cout << " (" << static_cast<double>(summary.turns) / simulation_time.count() << " turns/s)";
+    }
+    std::cout << "\n";
+    std::cout << "Peak memory: " << usage.ru_maxrss << " KiB\n";
+    std::cout << "Queues and stockpiles: " << factory_resource.get_bytes_in_use() << " bytes allocated (peak "
+              << factory_resource.get_peak_bytes() << ", " << factory_resource.get_allocations() << " allocations)\n\n";
+    generate_memory_report(memory, std::cout, 5);
     return 0;
 }
+
+int main(int argc, char* argv[])
+{
+    DriverOptions options;
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            if (std::string(argv[i]) == "--help" || std::string(argv[i]) == "-h")
+            {
+                print_usage(argv[0]);
+                return 0;
+            }
+        }
+        options = parse_options(argc, argv);
+    }
+    catch (std::exception& err)
+    {
+        std::cerr << err.what() << "\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        return run(options);
+    }
+    catch (std::exception& err)
+    {
+        std::cerr << err.what() << "\n";
+        return 1;
+    }
+}
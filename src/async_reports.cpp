@@ -0,0 +1,217 @@
+#include "async_reports.hpp"
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+void take_turn_snapshot(const Factory& f, Time t, TurnSnapshot& snapshot)
+{
+    INSTRUMENT_SCOPE("take_turn_snapshot");
+    snapshot.time = t;
+    snapshot.workers.clear();
+    snapshot.storehouses.clear();
+    snapshot.packages.clear();
+
+    std::for_each(f.worker_cbegin(), f.worker_cend(), [&snapshot](const Worker& worker)
+    {
+        std::size_t queue_begin = snapshot.packages.size();
+        for (auto iter = worker.cbegin(); iter != worker.cend(); ++iter)
+        {
+            snapshot.packages.push_back(iter->get_id());
+        }
+
+        const auto& processing_buffer = worker.get_processing_buffer();
+        const auto& sending_buffer = worker.get_sending_buffer();
+        snapshot.workers.push_back({worker.get_id(),
+                                    processing_buffer ? processing_buffer->get_id() : 0,
+                                    worker.get_package_processing_start_time(),
+                                    sending_buffer ? sending_buffer->get_id() : 0,
+                                    queue_begin, snapshot.packages.size()});
+    });
+
+    std::for_each(f.storehouse_cbegin(), f.storehouse_cend(), [&snapshot](const Storehouse& storehouse)
+    {
+        std::size_t stock_begin = snapshot.packages.size();
+        for (auto iter = storehouse.cbegin(); iter != storehouse.cend(); ++iter)
+        {
+            snapshot.packages.push_back(iter->get_id());
+        }
+        snapshot.storehouses.push_back({storehouse.get_id(), stock_begin, snapshot.packages.size()});
+    });
+}
+
+void generate_snapshot_report_packages(const TurnSnapshot& snapshot, std::size_t begin, std::size_t end, BufferedWriter& writer)
+{
+    if (begin == end)
+    {
+        writer << "(empty)";
+    }
+    for (std::size_t i = begin; i != end; ++i)
+    {
+        if (i != begin)
+        {
+            writer << ", ";
+        }
+        writer << '#' << snapshot.packages[i];
+    }
+}
+
+void generate_simulation_turn_report(const TurnSnapshot& snapshot, BufferedWriter& writer)
+{
+    INSTRUMENT_SCOPE("turn_report");
+    writer << "=== [ Turn: " << snapshot.time << " ] ===\n\n";
+
+    writer << "== WORKERS ==\n\n";
+    for (const auto& worker : snapshot.workers)
+    {
+        writer << "WORKER #" << worker.id << "\n";
+        writer << "  PBuffer: ";
+        if (worker.processing_buffer != 0)
+        {
+            writer << '#' << worker.processing_buffer << " (pt = " << worker.processing_start_time << ")\n";
+        }
+        else
+        {
+            writer << "(empty)\n";
+        }
+
+        writer << "  Queue: ";
+        generate_snapshot_report_packages(snapshot, worker.queue_begin, worker.queue_end, writer);
+        writer << "\n";
+
+        writer << "  SBuffer: ";
+        if (worker.sending_buffer != 0)
+        {
+            writer << '#' << worker.sending_buffer;
+        }
+        else
+        {
+            writer << "(empty)";
+        }
+        writer << "\n\n";
+    }
+
+    writer << "\n== STOREHOUSES ==\n\n";
+    for (const auto& storehouse : snapshot.storehouses)
+    {
+        writer << "STOREHOUSE #" << storehouse.id << "\n";
+        writer << "  Stock: ";
+        generate_snapshot_report_packages(snapshot, storehouse.stock_begin, storehouse.stock_end, writer);
+        writer << "\n";
+    }
+    writer << "\n";
+
+    writer.flush();
+}
+
+
+AsyncReportWriter::AsyncReportWriter(std::ostream &os, std::size_t max_pending): writer_(os), maxPending_{std::max<std::size_t>(max_pending, 1)}
+{
+    start();
+}
+
+AsyncReportWriter::AsyncReportWriter(const std::string &path, std::size_t max_pending): writer_(path), maxPending_{std::max<std::size_t>(max_pending, 1)}
+{
+    start();
+}
+
+AsyncReportWriter::~AsyncReportWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+        /// Write errors are reported by an explicit close(), never by the destructor
+    }
+}
+
+void AsyncReportWriter::start()
+{
+    thread_ = std::thread(&AsyncReportWriter::run, this);
+}
+
+void AsyncReportWriter::operator()(Factory &f, Time t)
+{
+    TurnSnapshot snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!recycled_.empty())
+        {
+            snapshot = std::move(recycled_.back());
+            recycled_.pop_back();
+        }
+    }
+
+    take_turn_snapshot(f, t, snapshot);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this]{return pending_.size() < maxPending_ || error_ || closed_;});
+        if (closed_)
+        {
+            throw std::logic_error("Report writer is closed");
+        }
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+        pending_.push_back(std::move(snapshot));
+    }
+    notEmpty_.notify_one();
+}
+
+void AsyncReportWriter::close()
+{
+    if (thread_.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        notEmpty_.notify_one();
+        notFull_.notify_all();
+        thread_.join();
+    }
+
+    if (error_)
+    {
+        std::rethrow_exception(error_);
+    }
+}
+
+void AsyncReportWriter::run()
+{
+    TurnSnapshot snapshot;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this]{return closed_ || !pending_.empty();});
+            if (pending_.empty())
+            {
+                return;
+            }
+            snapshot = std::move(pending_.front());
+            pending_.pop_front();
+        }
+        notFull_.notify_one();
+
+        try
+        {
+            generate_simulation_turn_report(snapshot, writer_);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_ = std::current_exception();
+            pending_.clear();
+            notFull_.notify_all();
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        recycled_.push_back(std::move(snapshot));
+    }
+}
@@ -0,0 +1,101 @@
+#include "buffered_writer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+BufferedWriter::BufferedWriter(std::ostream &os, std::size_t capacity): buffer_(std::max<std::size_t>(capacity, 64)), os_{&os} {}
+
+BufferedWriter::BufferedWriter(int fd, std::size_t capacity): buffer_(std::max<std::size_t>(capacity, 64)), fd_{fd} {}
+
+BufferedWriter::BufferedWriter(const std::string &path, std::size_t capacity): buffer_(std::max<std::size_t>(capacity, 64))
+{
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+    }
+    ownsFd_ = true;
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+        /// Write errors are reported by an explicit flush(), never by the destructor
+    }
+    if (ownsFd_)
+    {
+        ::close(fd_);
+    }
+}
+
+BufferedWriter &BufferedWriter::operator<<(char c)
+{
+    reserve(1);
+    buffer_[size_++] = c;
+    return *this;
+}
+
+BufferedWriter &BufferedWriter::write(const void *data, std::size_t size)
+{
+    if (size > buffer_.size())
+    {
+        /// Large block - no point in copying it through the buffer
+        drain();
+        emit(static_cast<const char*>(data), size);
+        return *this;
+    }
+    reserve(size);
+    std::memcpy(buffer_.data() + size_, data, size);
+    size_ += size;
+    return *this;
+}
+
+void BufferedWriter::flush()
+{
+    drain();
+    if (os_ != nullptr)
+    {
+        os_->flush();
+    }
+}
+
+void BufferedWriter::drain()
+{
+    if (size_ != 0)
+    {
+        std::size_t size = size_;
+        size_ = 0;
+        emit(buffer_.data(), size);
+    }
+}
+
+void BufferedWriter::emit(const char *data, std::size_t size)
+{
+    if (os_ != nullptr)
+    {
+        os_->write(data, static_cast<std::streamsize>(size));
+        return;
+    }
+
+    while (size != 0)
+    {
+        ssize_t written = ::write(fd_, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR) {continue;}
+            throw std::system_error(errno, std::generic_category(), "Write failed");
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
@@ -0,0 +1,108 @@
+#include "convergence.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+ConvergenceMonitor::ConvergenceMonitor(ConvergenceParameters params): params_{params}
+{
+    if (params_.window < 1 || params_.stable_windows == 0 || params_.divergent_windows == 0)
+    {
+        throw std::invalid_argument("Convergence window and window counts must be positive");
+    }
+}
+
+void ConvergenceMonitor::reset()
+{
+    *this = ConvergenceMonitor(params_);
+}
+
+bool is_close(double a, double b, double tolerance)
+{
+    return std::abs(a - b) <= tolerance * std::max({std::abs(a), std::abs(b), 1.0});
+}
+
+StopReason ConvergenceMonitor::observe(const Factory& f, Time)
+{
+    /// Zmiana struktury - nowe okna od zera
+    std::size_t worker_count = static_cast<std::size_t>(std::distance(f.worker_cbegin(), f.worker_cend()));
+    bool same_workers = worker_count == workerIds_.size()
+        && std::equal(workerIds_.begin(), workerIds_.end(), f.worker_cbegin(), f.worker_cend(),
+                      [](ElementID id, const Worker& worker) {return id == worker.get_id();});
+    if (!same_workers)
+    {
+        reset();
+        std::for_each(f.worker_cbegin(), f.worker_cend(), [this](const Worker& worker) {workerIds_.push_back(worker.get_id());});
+        workerQueueSums_.assign(worker_count, 0);
+        workerPreviousMeans_.assign(worker_count, 0);
+        workerGrowthStreaks_.assign(worker_count, 0);
+    }
+
+    std::size_t i = 0;
+    std::for_each(f.worker_cbegin(), f.worker_cend(), [this, &i](const Worker& worker)
+    {
+        auto queue_length = static_cast<double>(worker.get_queue()->size());
+        queueLengthSum_ += queue_length;
+        workerQueueSums_[i++] += queue_length;
+    });
+
+    std::uint64_t stored = 0;
+    std::for_each(f.storehouse_cbegin(), f.storehouse_cend(), [&stored](const Storehouse& storehouse)
+    {
+        stored += storehouse.get_received_count();
+    });
+    if (hasLastStored_ && stored >= lastStored_)
+    {
+        inflowSum_ += stored - lastStored_;
+    }
+    lastStored_ = stored;
+    hasLastStored_ = true;
+
+    if (++turnsInWindow_ < params_.window)
+    {
+        return StopReason::COMPLETED;
+    }
+    return close_window();
+}
+
+StopReason ConvergenceMonitor::close_window()
+{
+    auto turns = static_cast<double>(turnsInWindow_);
+    double queue_mean = queueLengthSum_ / turns;
+    double inflow_mean = static_cast<double>(inflowSum_) / turns;
+
+    StopReason reason = StopReason::COMPLETED;
+    for (std::size_t i = 0; i < workerIds_.size(); ++i)
+    {
+        double mean = workerQueueSums_[i] / turns;
+        bool growing = hasPreviousWindow_ && mean - workerPreviousMeans_[i] >= params_.queue_growth;
+        workerGrowthStreaks_[i] = growing ? workerGrowthStreaks_[i] + 1 : 0;
+        workerPreviousMeans_[i] = mean;
+        workerQueueSums_[i] = 0;
+
+        if (reason == StopReason::COMPLETED && workerGrowthStreaks_[i] >= params_.divergent_windows)
+        {
+            reason = StopReason::DIVERGED;
+            divergingWorker_ = workerIds_[i];
+        }
+    }
+
+    if (reason == StopReason::COMPLETED && hasPreviousWindow_)
+    {
+        bool stable = is_close(queue_mean, previousQueueMean_, params_.tolerance)
+                      && is_close(inflow_mean, previousInflowMean_, params_.tolerance);
+        stableStreak_ = stable ? stableStreak_ + 1 : 0;
+        if (stableStreak_ >= params_.stable_windows)
+        {
+            reason = StopReason::STEADY_STATE;
+        }
+    }
+
+    hasPreviousWindow_ = true;
+    previousQueueMean_ = queue_mean;
+    previousInflowMean_ = inflow_mean;
+    turnsInWindow_ = 0;
+    queueLengthSum_ = 0;
+    inflowSum_ = 0;
+    return reason;
+}
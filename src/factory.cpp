@@ -1,7 +1,13 @@
 #include "factory.hpp"
+#include "instrumentation.hpp"
 
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <optional>
 #include <stdexcept>
 #include <sstream>
+#include <variant>
 
 enum class NodeColor { UNVISITED, VISITED, VERIFIED };
 
@@ -48,6 +54,7 @@ bool has_reachable_storehouse(const PackageSender* sender, std::map<const Packag
 
 bool Factory::is_consistent() const
 {
+   INSTRUMENT_SCOPE("is_consistent");
    std::map<const PackageSender*, NodeColor> colour;
 
    for (auto &ramp : rampCollection_)
@@ -74,30 +81,544 @@ bool Factory::is_consistent() const
     return true;
 }
 
+void Factory::remove_ramp(ElementID id)
+{
+    if (auto it = rampCollection_.find_by_id(id); it != rampCollection_.end())
+    {
+        retire_packages(*it);
+        rampCollection_.remove_by_id(id);
+        schedulesDirty_ = true;
+    }
+}
+
+void Factory::retire_packages(const PackageSender &sender)
+{
+    if (!packageLedger_)
+    {
+        return;
+    }
+    if (sender.get_sending_buffer().has_value())
+    {
+        packageLedger_->retire(*sender.get_sending_buffer());
+    }
+}
+
+void Factory::retire_packages(const Worker &worker)
+{
+    if (!packageLedger_)
+    {
+        return;
+    }
+    retire_packages(static_cast<const PackageSender&>(worker));
+    if (worker.get_processing_buffer().has_value())
+    {
+        packageLedger_->retire(*worker.get_processing_buffer());
+    }
+    for (const Package& package : worker)
+    {
+        packageLedger_->retire(package);
+    }
+}
+
+void Factory::adopt_packages(const PackageSender &sender)
+{
+    if (packageLedger_ && sender.get_sending_buffer().has_value())
+    {
+        packageLedger_->adopt(*sender.get_sending_buffer());
+    }
+}
+
+void Factory::adopt_packages(const Worker &worker)
+{
+    if (!packageLedger_)
+    {
+        return;
+    }
+    adopt_packages(static_cast<const PackageSender&>(worker));
+    if (worker.get_processing_buffer().has_value())
+    {
+        packageLedger_->adopt(*worker.get_processing_buffer());
+    }
+    for (const Package& package : worker)
+    {
+        packageLedger_->adopt(package);
+    }
+}
+
 void Factory::do_deliveries(Time time)
 {
-    for (auto &ramp : rampCollection_)
+    INSTRUMENT_SCOPE("do_deliveries");
+    if (statistics_)
+    {
+        statistics_->start_turn(time);
+    }
+
+    if (rampSchedule_)
     {
-        ramp.deliver_goods(time);
+        update_schedules();
+        const std::vector<std::uint32_t>& fired = rampSchedule_->advance(time);
+        auto next_fired = fired.begin();
+        std::uint32_t index = 0;
+        for (auto &ramp : rampCollection_)
+        {
+            bool delivery_turn = next_fired != fired.end() && *next_fired == index;
+            next_fired += delivery_turn;
+            deliver_goods(ramp, time, delivery_turn);
+            ++index;
+        }
+    }
+    else
+    {
+        for (auto &ramp : rampCollection_)
+        {
+            deliver_goods(ramp, time, time % ramp.get_delivery_interval() == 0);
+        }
+    }
+}
+
+void Factory::deliver_goods(Ramp &ramp, Time time, bool delivery_turn)
+{
+    IPackageReceiver* receiver = ramp.deliver_goods(time, delivery_turn);
+    if (trackChanges_ && receiver != nullptr)
+    {
+        changedReceivers_.insert(receiver);
     }
 }
 
 void Factory::do_package_passing()
 {
+    INSTRUMENT_SCOPE("do_package_passing");
+    if (batchedPassing_ && std::none_of(workerCollection_.cbegin(), workerCollection_.cend(),
+                                        [](const Worker& worker) {return worker.get_capacity() != 0;}))
+    {
+        do_batched_package_passing();
+        return;
+    }
+
+    for (auto &ramp : rampCollection_)
+    {
+        IPackageReceiver* receiver = ramp.send_package();
+        if (trackChanges_ && receiver != nullptr)
+        {
+            changedReceivers_.insert(receiver);
+        }
+    }
+
+    for (auto &worker : workerCollection_)
+    {
+        IPackageReceiver* receiver = worker.send_package();
+        if (trackChanges_ && receiver != nullptr)
+        {
+            changedReceivers_.insert(receiver);
+            changedReceivers_.insert(&worker);
+        }
+    }
+}
+
+void Factory::do_batched_package_passing()
+{
+    pendingSends_.clear();
     for (auto &ramp : rampCollection_)
     {
-        ramp.send_package();
+        if (ramp.get_sending_buffer()) {pendingSends_.push_back({&ramp, nullptr, nullptr, pendingSends_.size()});}
+    }
+    for (auto &worker : workerCollection_)
+    {
+        if (worker.get_sending_buffer()) {pendingSends_.push_back({&worker, &worker, nullptr, pendingSends_.size()});}
+    }
+
+    /// Losowania w tej samej kolejności co przy przekazywaniu sekwencyjnym
+    for (auto &pending : pendingSends_)
+    {
+        const ReceiverPreferences& preferences = pending.sender->receiver_preferences_;
+        if (preferences.get_preferences().empty())
+        {
+            continue;
+        }
+        double u = 0;
+        if (preferences.has_default_generator())
+        {
+            u = std::generate_canonical<double, 10>(rng);
+            INSTRUMENT_COUNT(RNG_DRAWS, 1);
+        }
+        else
+        {
+            u = preferences.probabilityGenerator_();
+        }
+        pending.receiver = preferences.choose_receiver(u);
+    }
+
+    /// Grupowanie po odbiorcy; w obrębie odbiorcy kolejność nadawców (jak przy przekazywaniu sekwencyjnym)
+    std::sort(pendingSends_.begin(), pendingSends_.end(), [](const PendingSend& a, const PendingSend& b)
+    {
+        return std::less<IPackageReceiver*>()(a.receiver, b.receiver) || (a.receiver == b.receiver && a.order < b.order);
+    });
+
+    for (auto &pending : pendingSends_)
+    {
+        IPackageReceiver* receiver = pending.sender->send_package(pending.receiver);
+        if (trackChanges_ && receiver != nullptr)
+        {
+            changedReceivers_.insert(receiver);
+            if (pending.worker != nullptr)
+            {
+                changedReceivers_.insert(pending.worker);
+            }
+        }
     }
 }
 
 void Factory::do_work(Time time)
 {
+    INSTRUMENT_SCOPE("do_work");
+    if (workerSchedule_)
+    {
+        update_schedules();
+        const std::vector<std::uint32_t>& fired = workerSchedule_->advance(time);
+        auto next_fired = fired.begin();
+        std::uint32_t index = 0;
+        for (auto &worker : workerCollection_)
+        {
+            bool finishing_turn = next_fired != fired.end() && *next_fired == index;
+            next_fired += finishing_turn;
+            do_work(worker, time, finishing_turn);
+            ++index;
+        }
+    }
+    else
+    {
+        for (auto &worker : workerCollection_)
+        {
+            do_work(worker, time, time % worker.get_processing_duration() == 0);
+        }
+    }
+}
+
+void Factory::do_work(Worker &worker, Time time, bool finishing_turn)
+{
+    if (trackChanges_)
+    {
+        /// Work changes a worker only by taking a package from the queue or finishing one
+        std::size_t queue_size = worker.get_queue()->size();
+        bool has_sending = worker.get_sending_buffer().has_value();
+
+        worker.do_work(time, finishing_turn);
+
+        if (queue_size != worker.get_queue()->size() || has_sending != worker.get_sending_buffer().has_value())
+        {
+            changedReceivers_.insert(&worker);
+        }
+    }
+    else
+    {
+        worker.do_work(time, finishing_turn);
+    }
+}
+
+void Factory::enable_countdown_scheduling(bool enabled, SchedulerKernel kernel)
+{
+    rampSchedule_ = enabled ? std::make_unique<CountdownScheduler>(kernel) : nullptr;
+    workerSchedule_ = enabled ? std::make_unique<CountdownScheduler>(kernel) : nullptr;
+    schedulesDirty_ = true;
+}
+
+void Factory::update_schedules()
+{
+    if (!schedulesDirty_)
+    {
+        return;
+    }
+
+    std::vector<TimeOffset> periods;
+    for (const auto &ramp : rampCollection_)
+    {
+        periods.push_back(ramp.get_delivery_interval());
+    }
+    rampSchedule_->set_periods(periods);
+
+    periods.clear();
+    for (const auto &worker : workerCollection_)
+    {
+        periods.push_back(worker.get_processing_duration());
+    }
+    workerSchedule_->set_periods(periods);
+
+    schedulesDirty_ = false;
+}
+
+void Factory::enable_statistics(bool enabled)
+{
+    statistics_ = enabled ? std::make_unique<StatisticsCollector>() : nullptr;
+
+    for (auto &ramp : rampCollection_)
+    {
+        ramp.attach_statistics(statistics_.get());
+    }
+    for (auto &worker : workerCollection_)
+    {
+        worker.attach_statistics(statistics_.get());
+    }
+    for (auto &storehouse : storehouseCollection_)
+    {
+        storehouse.attach_statistics(statistics_.get());
+    }
+}
+
+void Factory::enable_package_ledger(bool enabled)
+{
+    packageLedger_ = enabled ? std::make_unique<PackageLedger>() : nullptr;
+
+    for (auto &ramp : rampCollection_)
+    {
+        ramp.attach_package_ledger(packageLedger_.get());
+        adopt_packages(ramp);
+    }
+    for (auto &worker : workerCollection_)
+    {
+        adopt_packages(worker);
+    }
+    for (auto &storehouse : storehouseCollection_)
+    {
+        storehouse.attach_package_ledger(packageLedger_.get());
+    }
+}
+
+void Factory::set_change_tracking(bool enabled)
+{
+    trackChanges_ = enabled;
+    changedReceivers_.clear();
+}
+
+void Factory::advance(Time t, TimeOffset k)
+{
+    INSTRUMENT_SCOPE("advance");
+    std::vector<DeterministicChain> chains;
+    if (!statistics_)
+    {
+        chains = find_deterministic_chains(k);
+    }
+    if (chains.empty())
+    {
+        for (Time time = t; time < t + k; ++time)
+        {
+            do_deliveries(time);
+            do_package_passing();
+            do_work(time);
+        }
+        return;
+    }
+
+    /// Łańcuchy nie wymieniają paczek z resztą grafu (poza magazynami), więc mogą iść pierwsze
+    std::unordered_set<const PackageSender*> chained;
+    for (const auto &chain : chains)
+    {
+        advance_chain(chain, t, k);
+        chained.insert(chain.ramp);
+        chained.insert(chain.workers.begin(), chain.workers.end());
+    }
+
+    std::vector<Ramp*> ramps;
+    std::vector<Worker*> workers;
+    for (auto &ramp : rampCollection_)
+    {
+        if (chained.count(&ramp) == 0) {ramps.push_back(&ramp);}
+    }
     for (auto &worker : workerCollection_)
     {
-        worker.do_work(time);
+        if (chained.count(&worker) == 0) {workers.push_back(&worker);}
+    }
+
+    for (Time time = t; time < t + k; ++time)
+    {
+        for (Ramp* ramp : ramps)
+        {
+            deliver_goods(*ramp, time, time % ramp->get_delivery_interval() == 0);
+        }
+        for (Ramp* ramp : ramps)
+        {
+            if (ramp->get_sending_buffer())
+            {
+                send_package(*ramp, nullptr, ramp->receiver_preferences_.choose_receiver());
+            }
+        }
+        for (Worker* worker : workers)
+        {
+            if (worker->get_sending_buffer())
+            {
+                send_package(*worker, worker, worker->receiver_preferences_.choose_receiver());
+            }
+        }
+        for (Worker* worker : workers)
+        {
+            do_work(*worker, time, time % worker->get_processing_duration() == 0);
+        }
     }
 }
 
+std::vector<Factory::DeterministicChain> Factory::find_deterministic_chains(TimeOffset max_period)
+{
+    std::unordered_map<const IPackageReceiver*, std::size_t> sender_count;
+    for (const auto &ramp : rampCollection_)
+    {
+        for (const auto &[receiver, probability] : ramp.receiver_preferences_) {++sender_count[receiver];}
+    }
+    for (const auto &worker : workerCollection_)
+    {
+        for (const auto &[receiver, probability] : worker.receiver_preferences_) {++sender_count[receiver];}
+    }
+
+    std::vector<DeterministicChain> chains;
+    for (auto &ramp : rampCollection_)
+    {
+        if (ramp.receiver_preferences_.get_preferences().size() != 1)
+        {
+            continue;
+        }
+
+        DeterministicChain chain{&ramp, {}, nullptr, ramp.get_delivery_interval()};
+        IPackageReceiver* next = ramp.receiver_preferences_.begin()->first;
+        while (next->get_receiver_type() == ReceiverType::WORKER)
+        {
+            auto worker = dynamic_cast<Worker*>(next);
+            if (sender_count[next] != 1 || worker->get_capacity() != 0 || worker->receiver_preferences_.get_preferences().size() != 1)
+            {
+                break;
+            }
+            chain.workers.push_back(worker);
+            if (chain.period != 0)
+            {
+                std::int64_t period = std::lcm<std::int64_t>(chain.period, worker->get_processing_duration());
+                chain.period = period <= max_period ? static_cast<TimeOffset>(period) : 0;
+            }
+            next = worker->receiver_preferences_.begin()->first;
+        }
+
+        chain.storehouse = dynamic_cast<Storehouse*>(next);
+        if (chain.storehouse != nullptr)
+        {
+            chains.push_back(std::move(chain));
+        }
+    }
+    return chains;
+}
+
+void Factory::advance_chain(const DeterministicChain &chain, Time t, TimeOffset k)
+{
+    /// Stan łańcucha co okres: bufor rampy, dla każdego robotnika długość kolejki i bufory
+    auto take_snapshot = [&chain](std::vector<std::size_t>& snapshot)
+    {
+        snapshot.clear();
+        snapshot.push_back(chain.ramp->get_sending_buffer().has_value());
+        for (const Worker* worker : chain.workers)
+        {
+            snapshot.push_back(worker->get_queue()->size());
+            snapshot.push_back(worker->get_processing_buffer().has_value());
+            snapshot.push_back(worker->get_sending_buffer().has_value());
+        }
+    };
+
+    /// The evolution over a period repeats if only queues differ and those never ran empty during it
+    auto repeats = [&chain](const std::vector<std::size_t>& previous, const std::vector<std::size_t>& current)
+    {
+        for (std::size_t i = 0; i < current.size(); ++i)
+        {
+            bool queue = i % 3 == 1;
+            if (queue ? current[i] < previous[i] || (current[i] > previous[i] && previous[i] <= static_cast<std::size_t>(chain.period))
+                      : current[i] != previous[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    Time end = t + k;
+    Time time = t;
+    std::size_t arrivals = 0;       /// In the current period
+    bool jumped = chain.period == 0;
+    std::vector<std::size_t> previous;
+    std::vector<std::size_t> current;
+    take_snapshot(previous);
+
+    while (time < end)
+    {
+        arrivals += step_chain(chain, time);
+        ++time;
+        if (jumped || (time - t) % chain.period != 0)
+        {
+            continue;
+        }
+
+        take_snapshot(current);
+        /// Co najmniej jeden pełny okres krokami na koniec - świeże czasy rozpoczęcia przetwarzania
+        TimeOffset periods = (end - time) / chain.period - 1;
+        if (repeats(previous, current) && periods > 0)
+        {
+            for (std::size_t i = 0; i < chain.workers.size(); ++i)
+            {
+                std::size_t growth = current[1 + 3 * i] - previous[1 + 3 * i];
+                chain.workers[i]->get_queue()->push_new(growth * static_cast<std::size_t>(periods));
+                if (growth != 0) {adopt_packages(*chain.workers[i]);}
+                if (trackChanges_ && growth != 0) {changedReceivers_.insert(chain.workers[i]);}
+            }
+            chain.storehouse->receive_new_packages(arrivals * static_cast<std::size_t>(periods));
+            if (trackChanges_ && arrivals != 0) {changedReceivers_.insert(chain.storehouse);}
+
+            time += periods * chain.period;
+            jumped = true;
+        }
+        std::swap(previous, current);
+        arrivals = 0;
+    }
+}
+
+std::size_t Factory::step_chain(const DeterministicChain &chain, Time time)
+{
+    std::size_t arrivals = 0;
+    auto send = [this, &chain, &arrivals](PackageSender& sender, IPackageReceiver* self, IPackageReceiver* receiver)
+    {
+        arrivals += send_package(sender, self, receiver) == chain.storehouse;
+    };
+    IPackageReceiver* first = chain.workers.empty() ? static_cast<IPackageReceiver*>(chain.storehouse) : chain.workers.front();
+
+    /// Jak Ramp::deliver_goods, ale bez losowania jedynego odbiorcy
+    if (time % chain.ramp->get_delivery_interval() == 0)
+    {
+        send(*chain.ramp, nullptr, first);
+    }
+    else
+    {
+        chain.ramp->deliver_goods(time, false);
+    }
+
+    send(*chain.ramp, nullptr, first);
+    for (std::size_t i = 0; i < chain.workers.size(); ++i)
+    {
+        bool last = i + 1 == chain.workers.size();
+        send(*chain.workers[i], chain.workers[i], last ? static_cast<IPackageReceiver*>(chain.storehouse) : chain.workers[i + 1]);
+    }
+
+    for (Worker* worker : chain.workers)
+    {
+        do_work(*worker, time, time % worker->get_processing_duration() == 0);
+    }
+    return arrivals;
+}
+
+IPackageReceiver* Factory::send_package(PackageSender &sender, IPackageReceiver *self, IPackageReceiver *receiver)
+{
+    IPackageReceiver* target = sender.send_package(receiver);
+    if (trackChanges_ && target != nullptr)
+    {
+        changedReceivers_.insert(target);
+        if (self != nullptr)
+        {
+            changedReceivers_.insert(self);
+        }
+    }
+    return target;
+}
+
 enum class ElementType
 {
     RAMP, WORKER, STOREHOUSE, LINK
@@ -137,7 +658,7 @@ struct ParsedLineData
 };
 
 
-ParsedLineData parse_line(std::string& line)
+ParsedLineData parse_line(const std::string& line)
 {
     constexpr char separator = ' ';
     constexpr char separator_of_param = '=';
@@ -159,9 +680,170 @@ ParsedLineData parse_line(std::string& line)
     return lineData;
 }
 
-Factory load_factory_structure(std::istream& is)
+/// "stockpile-type=COUNTER", "stockpile-type=HANDLES" or "stockpile-type=RING stockpile-capacity=K"; a LIFO queue by default
+std::unique_ptr<IPackageStockpile> make_stockpile(const ParsedLineData& lineData, std::pmr::memory_resource* resource)
+{
+    auto type = lineData.parameters.find("stockpile-type");
+    if (type == lineData.parameters.end() || type->second == "LIFO")
+    {
+        return std::make_unique<PackageQueue>(PackageQueueType::LIFO, resource);
+    }
+    if (type->second == "FIFO")
+    {
+        return std::make_unique<PackageQueue>(PackageQueueType::FIFO, resource);
+    }
+    if (type->second == "COUNTER")
+    {
+        return std::make_unique<CountingStockpile>();
+    }
+    if (type->second == "HANDLES")
+    {
+        return std::make_unique<HandleStockpile>(resource);
+    }
+    if (type->second == "RING")
+    {
+        return std::make_unique<RingStockpile>(std::stoull(lineData.parameters.at("stockpile-capacity")), resource);
+    }
+    throw std::runtime_error("Unknown stockpile type!");
+}
+
+using Node = std::variant<Ramp, Worker, Storehouse>;
+
+/// Builds the node described by a structure line, without adding it to the factory
+Node make_node(Factory& factory, const ParsedLineData& lineData)
+{
+    if (lineData.element_type == ElementType::RAMP)
+    {
+        ElementID id = std::stoull(lineData.parameters.at("id"));
+        TimeOffset t = std::stoi(lineData.parameters.at("delivery-interval"));
+        return Ramp(id, t);
+    }
+
+    else if(lineData.element_type == ElementType::WORKER)
+    {
+        ElementID id = std::stoull(lineData.parameters.at("id"));
+        TimeOffset t = std::stoi(lineData.parameters.at("processing-time"));
+        PackageQueueType queueType = lineData.parameters.at("queue-type") == "LIFO" ? PackageQueueType::LIFO : PackageQueueType::FIFO;
+
+        std::unique_ptr<IPackageQueue> uniquePtr = std::make_unique<PackageQueue>(queueType, factory.get_memory_resource());
+
+        std::size_t capacity = 0;
+        if (auto it = lineData.parameters.find("capacity"); it != lineData.parameters.end())
+        {
+            capacity = std::stoull(it->second);
+        }
+        BackpressurePolicy policy = BackpressurePolicy::RETRY;
+        if (auto it = lineData.parameters.find("backpressure"); it != lineData.parameters.end())
+        {
+            if (it->second == "REROUTE") {policy = BackpressurePolicy::REROUTE;}
+            else if (it->second != "RETRY") {throw std::runtime_error("Unknown backpressure policy!");}
+        }
+
+        return Worker(id, t, std::move(uniquePtr), capacity, policy);
+    }
+
+    else if(lineData.element_type == ElementType::STOREHOUSE)
+    {
+        ElementID id = std::stoull(lineData.parameters.at("id"));
+        return Storehouse(id, make_stockpile(lineData, factory.get_memory_resource()));
+    }
+
+    else
+    {
+        throw std::runtime_error("Not a node tag!");
+    }
+}
+
+void add_node(Factory& factory, Ramp&& ramp) {factory.add_ramp(std::move(ramp));}
+void add_node(Factory& factory, Worker&& worker) {factory.add_worker(std::move(worker));}
+void add_node(Factory& factory, Storehouse&& storehouse) {factory.add_storehouse(std::move(storehouse));}
+
+void add_node(Factory& factory, Node&& node)
+{
+    std::visit([&factory](auto&& n){ add_node(factory, std::move(n)); }, std::move(node));
+}
+
+ElementType node_type(const Node& node)
+{
+    static constexpr ElementType types[] = {ElementType::RAMP, ElementType::WORKER, ElementType::STOREHOUSE};
+    return types[node.index()];
+}
+
+ElementID node_id(const Node& node)
+{
+    return std::visit([](const auto& n){ return n.get_id(); }, node);
+}
+
+bool has_node(const Factory& factory, ElementType type, ElementID id)
+{
+    switch (type)
+    {
+        case ElementType::RAMP:
+            return factory.find_ramp_by_id(id) != factory.ramp_cend();
+        case ElementType::WORKER:
+            return factory.find_worker_by_id(id) != factory.worker_cend();
+        case ElementType::STOREHOUSE:
+            return factory.find_storehouse_by_id(id) != factory.storehouse_cend();
+        case ElementType::LINK:
+            break;
+    }
+    return false;
+}
+
+struct LinkEnds
+{
+    ElementType src_type;
+    ElementID src_id;
+    ElementType dest_type;
+    ElementID dest_id;
+};
+
+/// Parses "src=<type>-<id> dest=<type>-<id>"
+LinkEnds parse_link(const ParsedLineData& lineData)
 {
-    Factory factory;
+    std::string_view src = lineData.parameters.at("src");
+    std::string_view dest = lineData.parameters.at("dest");
+
+    std::size_t src_idx = src.find('-');
+    std::size_t dest_idx = dest.find('-');
+
+    return {str2ElementType(src.substr(0, src_idx)), std::stoull(std::string(src.substr(src_idx+1))),
+            str2ElementType(dest.substr(0, dest_idx)), std::stoull(std::string(dest.substr(dest_idx+1)))};
+}
+
+/// Resolves the ends of a link to the nodes of the factory
+std::pair<PackageSender*, IPackageReceiver*> resolve_link(Factory& factory, const LinkEnds& link)
+{
+    IPackageReceiver* pReceiver = nullptr;
+    if (link.dest_type == ElementType::WORKER)
+    {
+        if (auto it = factory.find_worker_by_id(link.dest_id); it != factory.worker_end()) {pReceiver = &(*it);}
+    }
+    else if (link.dest_type == ElementType::STOREHOUSE)
+    {
+        if (auto it = factory.find_storehouse_by_id(link.dest_id); it != factory.storehouse_end()) {pReceiver = &(*it);}
+    }
+
+    PackageSender* pSender = nullptr;
+    if (link.src_type == ElementType::RAMP)
+    {
+        if (auto it = factory.find_ramp_by_id(link.src_id); it != factory.ramp_end()) {pSender = &(*it);}
+    }
+    else if (link.src_type == ElementType::WORKER)
+    {
+        if (auto it = factory.find_worker_by_id(link.src_id); it != factory.worker_end()) {pSender = &(*it);}
+    }
+
+    if (pSender == nullptr || pReceiver == nullptr)
+    {
+        throw std::runtime_error("Unknown node in link!");
+    }
+    return {pSender, pReceiver};
+}
+
+Factory load_factory_structure(std::istream& is, std::pmr::memory_resource* resource)
+{
+    Factory factory(resource);
 
     std::string line;
     while (std::getline(is, line))
@@ -173,127 +855,297 @@ Factory load_factory_structure(std::istream& is)
 
         ParsedLineData lineData = parse_line(line);
 
-        if (lineData.element_type == ElementType::RAMP)
+        if (lineData.element_type == ElementType::LINK)
         {
-            ElementID id = std::stoull(lineData.parameters.at("id"));
-            TimeOffset t = std::stoi(lineData.parameters.at("delivery-interval"));
-            factory.add_ramp(Ramp(id, t));
+            auto [pSender, pReceiver] = resolve_link(factory, parse_link(lineData));
+            pSender->receiver_preferences_.add_receiver(pReceiver);
         }
-
-        else if(lineData.element_type == ElementType::WORKER)
+        else
         {
-            ElementID id = std::stoull(lineData.parameters.at("id"));
-            TimeOffset t = std::stoi(lineData.parameters.at("processing-time"));
-            PackageQueueType queueType = lineData.parameters.at("queue-type") == "LIFO" ? PackageQueueType::LIFO : PackageQueueType::FIFO;
+            add_node(factory, make_node(factory, lineData));
+        }
+    }
+    return factory;
+}
+
+enum class PatchCommand
+{
+    ADD, REMOVE, LINK, UNLINK
+};
 
-            std::unique_ptr<IPackageQueue> uniquePtr = std::make_unique<PackageQueue>(PackageQueue(queueType));
+struct PatchStep
+{
+    PatchCommand command;
+    std::optional<Node> node;       /// ADD
+    ElementType element_type;       /// REMOVE
+    ElementID id;                   /// REMOVE
+    LinkEnds link;                  /// LINK, UNLINK
+};
 
-            factory.add_worker(Worker(id, t, std::move(uniquePtr)));
-        }
+/// Parses the patch and checks it against the factory as it will be after each step, so applying it cannot fail
+std::vector<PatchStep> parse_factory_patch(Factory& factory, std::istream& is)
+{
+    /// Węzły dodane (true) lub usunięte (false) przez wcześniejsze kroki; pozostałe jak w fabryce
+    std::map<std::pair<ElementType, ElementID>, bool> patched;
+    auto exists = [&factory, &patched](ElementType type, ElementID id)
+    {
+        auto it = patched.find({type, id});
+        return it != patched.end() ? it->second : has_node(factory, type, id);
+    };
 
-        else if(lineData.element_type == ElementType::STOREHOUSE)
+    std::vector<PatchStep> steps;
+    std::string line;
+    while (std::getline(is, line))
+    {
+        if (line.empty() || line[0] == ';')
         {
-            ElementID id = std::stoull(lineData.parameters.at("id"));
-            factory.add_storehouse(Storehouse(id));
+            continue;
         }
 
-        else if(lineData.element_type == ElementType::LINK)
+        std::size_t idx = line.find(' ');
+        std::string_view command = std::string_view(line).substr(0, idx);
+        std::string arguments = idx == std::string::npos ? std::string() : line.substr(idx + 1);
+
+        PatchStep step{};
+        if (command == "ADD")
         {
-            std::string_view src = lineData.parameters.at("src");
-            std::string_view dest = lineData.parameters.at("dest");
+            step.command = PatchCommand::ADD;
+            step.node.emplace(make_node(factory, parse_line(arguments)));
+            step.element_type = node_type(*step.node);
+            step.id = node_id(*step.node);
+            if (exists(step.element_type, step.id))
+            {
+                throw std::invalid_argument("Duplicate node ID " + std::to_string(step.id));
+            }
+            patched[{step.element_type, step.id}] = true;
+        }
+        else if (command == "REMOVE")
+        {
+            ParsedLineData lineData = parse_line(arguments);
+            if (lineData.element_type == ElementType::LINK)
+            {
+                throw std::runtime_error("Not a node tag!");
+            }
+            step.command = PatchCommand::REMOVE;
+            step.element_type = lineData.element_type;
+            step.id = std::stoull(lineData.parameters.at("id"));
+            patched[{step.element_type, step.id}] = false;
+        }
+        else if (command == "LINK" || command == "UNLINK")
+        {
+            step.command = command == "LINK" ? PatchCommand::LINK : PatchCommand::UNLINK;
+            step.link = parse_link(parse_line("LINK " + arguments));
+            bool src_ok = step.link.src_type == ElementType::RAMP || step.link.src_type == ElementType::WORKER;
+            bool dest_ok = step.link.dest_type == ElementType::WORKER || step.link.dest_type == ElementType::STOREHOUSE;
+            if (!src_ok || !dest_ok || !exists(step.link.src_type, step.link.src_id) || !exists(step.link.dest_type, step.link.dest_id))
+            {
+                throw std::runtime_error("Unknown node in link!");
+            }
+        }
+        else
+        {
+            throw std::runtime_error("Unknown patch command!");
+        }
+        steps.push_back(std::move(step));
+    }
+    return steps;
+}
 
-            std::size_t src_idx = src.find('-');
-            std::size_t dest_idx = dest.find('-');
+/// Receiver -> senders linked to it; built at the first REMOVE of a patch and kept up to date by the later steps
+using SenderIndex = std::unordered_map<const IPackageReceiver*, std::vector<PackageSender*>>;
 
-            ElementType src_node_type = str2ElementType(src.substr(0, src_idx));
-            ElementType dest_node_type = str2ElementType(dest.substr(0, dest_idx));
+SenderIndex index_senders(Factory& factory)
+{
+    SenderIndex senders;
+    auto index = [&senders](PackageSender& sender)
+    {
+        for (const auto &[receiver, probability] : sender.receiver_preferences_)
+        {
+            senders[receiver].push_back(&sender);
+        }
+    };
+    std::for_each(factory.ramp_begin(), factory.ramp_end(), index);
+    std::for_each(factory.worker_begin(), factory.worker_end(), index);
+    return senders;
+}
 
-            ElementID src_id = std::stoull(std::string(src.substr(src_idx+1)));
-            ElementID dest_id = std::stoull(std::string(dest.substr(dest_idx+1)));
+void unindex_link(SenderIndex& senders, const IPackageReceiver* receiver, const PackageSender* sender)
+{
+    auto& linked = senders[receiver];
+    linked.erase(std::find(linked.begin(), linked.end(), sender));
+}
+
+/// Drops the links of a removed sender from the index (O(out-degree))
+void unindex_sender(SenderIndex& senders, const PackageSender& sender)
+{
+    for (const auto &[receiver, probability] : sender.receiver_preferences_)
+    {
+        unindex_link(senders, receiver, &sender);
+    }
+}
 
-            IPackageReceiver* pReceiver = nullptr;
-            if (dest_node_type == ElementType::WORKER)
+void remove_node(Factory& factory, ElementType type, ElementID id, SenderIndex& senders)
+{
+    switch (type)
+    {
+        case ElementType::RAMP:
+            if (auto it = factory.find_ramp_by_id(id); it != factory.ramp_end())
             {
-                pReceiver = &(*factory.find_worker_by_id(dest_id));
+                unindex_sender(senders, *it);
+                factory.remove_ramp(id);
             }
-            else if (dest_node_type == ElementType::STOREHOUSE)
+            break;
+        case ElementType::WORKER:
+            if (auto it = factory.find_worker_by_id(id); it != factory.worker_end())
             {
-                pReceiver = &(*factory.find_storehouse_by_id(dest_id));
+                unindex_sender(senders, *it);
+                auto linked = senders.extract(&(*it));
+                factory.remove_worker(id, linked ? linked.mapped() : std::vector<PackageSender*>());
             }
+            break;
+        case ElementType::STOREHOUSE:
+            if (auto it = factory.find_storehouse_by_id(id); it != factory.storehouse_end())
+            {
+                auto linked = senders.extract(&(*it));
+                factory.remove_storehouse(id, linked ? linked.mapped() : std::vector<PackageSender*>());
+            }
+            break;
+        case ElementType::LINK:
+            break;
+    }
+}
 
-            if (src_node_type == ElementType::RAMP)
+void apply_factory_patch(Factory& factory, std::istream& is)
+{
+    std::vector<PatchStep> steps = parse_factory_patch(factory, is);
+
+    std::optional<SenderIndex> senders;
+    for (PatchStep& step : steps)
+    {
+        switch (step.command)
+        {
+            case PatchCommand::ADD:
+                add_node(factory, std::move(*step.node));
+                break;
+            case PatchCommand::REMOVE:
+                if (!senders)
+                {
+                    senders = index_senders(factory);
+                }
+                remove_node(factory, step.element_type, step.id, *senders);
+                break;
+            case PatchCommand::LINK:
             {
-                factory.find_ramp_by_id(src_id)->receiver_preferences_.add_receiver(pReceiver);
+                auto [pSender, pReceiver] = resolve_link(factory, step.link);
+                if (senders && pSender->receiver_preferences_.get_preferences().count(pReceiver) == 0)
+                {
+                    (*senders)[pReceiver].push_back(pSender);
+                }
+                pSender->receiver_preferences_.add_receiver(pReceiver);
+                break;
             }
-            else if (src_node_type == ElementType::WORKER)
+            case PatchCommand::UNLINK:
             {
-                factory.find_worker_by_id(src_id)->receiver_preferences_.add_receiver(pReceiver);
+                auto [pSender, pReceiver] = resolve_link(factory, step.link);
+                if (senders && pSender->receiver_preferences_.get_preferences().count(pReceiver) != 0)
+                {
+                    unindex_link(*senders, pReceiver, pSender);
+                }
+                pSender->receiver_preferences_.remove_receiver(pReceiver);
+                break;
             }
-
         }
-
     }
-    return factory;
 }
 
-std::vector<std::string> destinations_to_vector(const PackageSender *packageSender)
+void save_links(const PackageSender &packageSender, std::string_view src, ElementID src_id, BufferedWriter& writer)
 {
-    std::string worker = "worker";
-    std::string store = "store";
+    for (const auto &[key, val] : packageSender.receiver_preferences_.get_preferences())
+    {
+        writer << "LINK src=" << src << src_id << " dest=" \
+            << (key->get_receiver_type() == ReceiverType::WORKER ? "worker-" : "store-") << key->get_id() << '\n';
+    }
+    writer << '\n';
+}
 
-    std::vector<std::string> destinations;
-    for (auto [key, val] : packageSender->receiver_preferences_.get_preferences())
+/// Nothing for the default LIFO queue
+void save_stockpile_type(const IPackageStockpile& stockpile, BufferedWriter& writer)
+{
+    if (auto queue = dynamic_cast<const PackageQueue*>(&stockpile); queue && queue->get_queue_type() == PackageQueueType::FIFO)
+    {
+        writer << " stockpile-type=FIFO";
+    }
+    else if (dynamic_cast<const CountingStockpile*>(&stockpile))
     {
-        std::string str = key->get_receiver_type() == ReceiverType::WORKER ? worker : store;
-        str += "-";
-        str += std::to_string(key->get_id());
-        destinations.push_back(str);
+        writer << " stockpile-type=COUNTER";
+    }
+    else if (dynamic_cast<const HandleStockpile*>(&stockpile))
+    {
+        writer << " stockpile-type=HANDLES";
+    }
+    else if (auto ring = dynamic_cast<const RingStockpile*>(&stockpile))
+    {
+        writer << " stockpile-type=RING stockpile-capacity=" << ring->get_capacity();
     }
-    return destinations;
 }
 
-void save_factory_structure(Factory& factory, std::ostream& os)
+void save_factory_structure(const Factory& factory, BufferedWriter& writer)
 {
-    os << "; == LOADING RAMPS ==\n\n";
-    std::for_each(factory.ramp_cbegin(), factory.ramp_cend(), [&os](const Ramp &ramp)
+    writer << "; == LOADING RAMPS ==\n\n";
+    std::for_each(factory.ramp_cbegin(), factory.ramp_cend(), [&writer](const Ramp &ramp)
     {
-        os << "LOADING_RAMP id=" << ramp.get_id() << " delivery-interval=" << ramp.get_delivery_interval() << "\n";
+        writer << "LOADING_RAMP id=" << ramp.get_id() << " delivery-interval=" << ramp.get_delivery_interval() << '\n';
     });
 
-    os << "; == WORKERS ==\n\n";
-    std::for_each(factory.worker_cbegin(), factory.worker_cend(), [&os](const Worker &worker)
+    writer << "; == WORKERS ==\n\n";
+    std::for_each(factory.worker_cbegin(), factory.worker_cend(), [&writer](const Worker &worker)
     {
-        os << "WORKER id=" << worker.get_id() << " processing-time=" << worker.get_processing_duration() \
-            << " queue-type=" << (worker.get_queue()->get_queue_type() == PackageQueueType::FIFO ? "FIFO" : "LIFO") << "\n";
+        writer << "WORKER id=" << worker.get_id() << " processing-time=" << worker.get_processing_duration() \
+            << " queue-type=" << (worker.get_queue()->get_queue_type() == PackageQueueType::FIFO ? "FIFO" : "LIFO");
+        if (worker.get_capacity() != 0)
+        {
+            writer << " capacity=" << worker.get_capacity() << " backpressure=" \
+                << (worker.get_backpressure_policy() == BackpressurePolicy::RETRY ? "RETRY" : "REROUTE");
+        }
+        writer << '\n';
     });
 
-    os << "; == STOREHOUSES ==\n\n";
-    std::for_each(factory.storehouse_cbegin(), factory.storehouse_cend(), [&os](const Storehouse &storehouse)
+    writer << "; == STOREHOUSES ==\n\n";
+    std::for_each(factory.storehouse_cbegin(), factory.storehouse_cend(), [&writer](const Storehouse &storehouse)
     {
-        os << "STOREHOUSE id=" << storehouse.get_id() << "\n";
+        writer << "STOREHOUSE id=" << storehouse.get_id();
+        save_stockpile_type(*storehouse.get_stockpile(), writer);
+        writer << '\n';
     });
 
-    os << "; == LINKS ==\n\n";
-    std::for_each(factory.ramp_cbegin(), factory.ramp_cend(), [&os](const Ramp &ramp)
+    writer << "; == LINKS ==\n\n";
+    std::for_each(factory.ramp_cbegin(), factory.ramp_cend(), [&writer](const Ramp &ramp)
     {
-       std::vector<std::string> des = destinations_to_vector(static_cast<const PackageSender*>(&ramp));
-       for (const auto& s : des)
-       {
-           os << "LINK src=ramp-" << ramp.get_id() << " dest=" << s << "\n";
-       }
-       os << "\n";
+        save_links(ramp, "ramp-", ramp.get_id(), writer);
     });
 
-    std::for_each(factory.worker_cbegin(), factory.worker_cend(), [&os](const Worker &worker)
+    std::for_each(factory.worker_cbegin(), factory.worker_cend(), [&writer](const Worker &worker)
     {
-        std::vector<std::string> des = destinations_to_vector(static_cast<const PackageSender*>(&worker));
-        for (const auto& s : des)
-        {
-            os << "LINK src=worker-" << worker.get_id() << " dest=" << s << "\n";
-        }
-        os << "\n";
+        save_links(worker, "worker-", worker.get_id(), writer);
     });
 
-    os.flush();
+    writer.flush();
+}
+
+void save_factory_structure(Factory& factory, std::ostream& os)
+{
+    BufferedWriter writer(os);
+    save_factory_structure(factory, writer);
+}
+
+void save_factory_structure(const Factory& factory, int fd)
+{
+    BufferedWriter writer(fd);
+    save_factory_structure(factory, writer);
 }
 
+void save_factory_structure(const Factory& factory, const std::string& path)
+{
+    BufferedWriter writer(path);
+    save_factory_structure(factory, writer);
+}
@@ -0,0 +1,145 @@
+#include "flow.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+double ramp_rate(const Ramp& ramp, RampRateModel model)
+{
+    auto interval = static_cast<double>(ramp.get_delivery_interval());
+    return model == RampRateModel::NOMINAL ? 1.0 / interval : (interval - 1.0) / interval;
+}
+
+struct FlowEdge
+{
+    std::size_t source;     /// Worker index
+    double probability;
+};
+
+FlowEstimate estimate_flow(const Factory& f, const FlowParameters& params)
+{
+    if (!f.is_consistent())
+    {
+        throw std::logic_error("Factory is not consistent");
+    }
+
+    FlowEstimate estimate;
+
+    /// Odbiorcy -> indeksy robotników i magazynów
+    std::unordered_map<const IPackageReceiver*, std::size_t> worker_index;
+    std::unordered_map<const IPackageReceiver*, std::size_t> storehouse_index;
+    std::for_each(f.worker_cbegin(), f.worker_cend(), [&](const Worker& worker)
+    {
+        worker_index.emplace(&worker, estimate.workers.size());
+        auto service_rate = 1.0 / static_cast<double>(worker.get_processing_duration());
+        estimate.workers.push_back({worker.get_id(), 0, service_rate, 0, 0, false});
+    });
+    std::for_each(f.storehouse_cbegin(), f.storehouse_cend(), [&](const Storehouse& storehouse)
+    {
+        storehouse_index.emplace(&storehouse, estimate.storehouses.size());
+        estimate.storehouses.push_back({storehouse.get_id(), 0});
+    });
+
+    std::vector<double> external(estimate.workers.size(), 0);
+    std::vector<std::vector<FlowEdge>> worker_inputs(estimate.workers.size());
+    std::vector<std::vector<FlowEdge>> storehouse_inputs(estimate.storehouses.size());
+
+    std::for_each(f.ramp_cbegin(), f.ramp_cend(), [&](const Ramp& ramp)
+    {
+        double rate = ramp_rate(ramp, params.ramp_rate);
+        estimate.input_rate += rate;
+        for (const auto& [receiver, probability] : ramp.receiver_preferences_.get_preferences())
+        {
+            if (auto it = worker_index.find(receiver); it != worker_index.end())
+            {
+                external[it->second] += rate * probability;
+            }
+            else if (auto st = storehouse_index.find(receiver); st != storehouse_index.end())
+            {
+                estimate.storehouses[st->second].arrival_rate += rate * probability;
+            }
+        }
+    });
+
+    std::size_t source = 0;
+    std::for_each(f.worker_cbegin(), f.worker_cend(), [&](const Worker& worker)
+    {
+        for (const auto& [receiver, probability] : worker.receiver_preferences_.get_preferences())
+        {
+            if (auto it = worker_index.find(receiver); it != worker_index.end())
+            {
+                worker_inputs[it->second].push_back({source, probability});
+            }
+            else if (auto st = storehouse_index.find(receiver); st != storehouse_index.end())
+            {
+                storehouse_inputs[st->second].push_back({source, probability});
+            }
+        }
+        ++source;
+    });
+
+    auto throughput = [&estimate](std::size_t w)
+    {
+        return std::min(estimate.workers[w].arrival_rate, estimate.workers[w].service_rate);
+    };
+
+    /// Gauss-Seidel - nowe wartości używane od razu w tej samej iteracji
+    while (!estimate.converged && estimate.iterations < params.max_iterations)
+    {
+        ++estimate.iterations;
+        double largest_change = 0;
+        for (std::size_t w = 0; w < estimate.workers.size(); ++w)
+        {
+            double arrival = external[w];
+            for (const FlowEdge& edge : worker_inputs[w])
+            {
+                arrival += throughput(edge.source) * edge.probability;
+            }
+            largest_change = std::max(largest_change, std::abs(arrival - estimate.workers[w].arrival_rate));
+            estimate.workers[w].arrival_rate = arrival;
+        }
+        estimate.converged = largest_change <= params.tolerance;
+    }
+
+    for (std::size_t w = 0; w < estimate.workers.size(); ++w)
+    {
+        WorkerFlow& worker = estimate.workers[w];
+        worker.throughput = throughput(w);
+        worker.utilization = worker.arrival_rate / worker.service_rate;
+        worker.bottleneck = worker.utilization >= 1.0 - params.tolerance;
+    }
+
+    for (std::size_t s = 0; s < estimate.storehouses.size(); ++s)
+    {
+        for (const FlowEdge& edge : storehouse_inputs[s])
+        {
+            estimate.storehouses[s].arrival_rate += estimate.workers[edge.source].throughput * edge.probability;
+        }
+        estimate.output_rate += estimate.storehouses[s].arrival_rate;
+    }
+
+    return estimate;
+}
+
+void generate_flow_report(const FlowEstimate& estimate, std::ostream& os)
+{
+    os << "== FLOW ESTIMATE ==\n\n";
+    os << "Input: " << estimate.input_rate << " per turn\n";
+    os << "Output: " << estimate.output_rate << " per turn\n";
+    os << "Iterations: " << estimate.iterations << (estimate.converged ? "" : " (not converged)") << "\n\n";
+
+    for (const auto& worker : estimate.workers)
+    {
+        os << "WORKER #" << worker.id << (worker.bottleneck ? " (BOTTLENECK)" : "") << "\n";
+        os << "  Arrival: " << worker.arrival_rate << ", service: " << worker.service_rate << " per turn\n";
+        os << "  Utilization: " << worker.utilization << "\n";
+    }
+
+    for (const auto& storehouse : estimate.storehouses)
+    {
+        os << "STOREHOUSE #" << storehouse.id << "\n";
+        os << "  Arrival: " << storehouse.arrival_rate << " per turn\n";
+    }
+    os.flush();
+}
@@ -0,0 +1,144 @@
+#include "generator.hpp"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+/// Workers of a layer have consecutive indices: [layer_begin(layer), layer_begin(layer + 1))
+class WorkerLayers
+{
+public:
+    WorkerLayers(std::size_t workers, std::size_t depth): workers_{workers}, depth_{std::max<std::size_t>(1, std::min(depth, workers))} {}
+
+    [[nodiscard]] std::size_t depth() const {return depth_;}
+    [[nodiscard]] std::size_t layer_begin(std::size_t layer) const {return layer * workers_ / depth_;}
+    [[nodiscard]] std::size_t layer_of(std::size_t worker) const {return ((worker + 1) * depth_ - 1) / workers_;}
+
+private:
+    std::size_t workers_;
+    std::size_t depth_;
+};
+
+/// Picks up to k distinct indices from [first, first + n)
+void sample_distinct(std::mt19937_64& rng, std::size_t first, std::size_t n, std::size_t k, std::vector<std::size_t>& out)
+{
+    out.clear();
+    if (k >= n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {out.push_back(first + i);}
+        return;
+    }
+
+    std::uniform_int_distribution<std::size_t> dist(first, first + n - 1);
+    while (out.size() < k)
+    {
+        std::size_t candidate = dist(rng);
+        if (std::find(out.begin(), out.end(), candidate) == out.end())
+        {
+            out.push_back(candidate);
+        }
+    }
+    std::sort(out.begin(), out.end());
+}
+
+void generate_factory_structure(const FactoryGeneratorParameters& params, BufferedWriter& writer)
+{
+    if (params.storehouses == 0 && (params.ramps != 0 || params.workers != 0))
+    {
+        throw std::invalid_argument("At least one storehouse is required");
+    }
+    if (params.fan_out == 0 || params.max_delivery_interval < 1 || params.max_processing_time < 1)
+    {
+        throw std::invalid_argument("Fan-out, delivery interval and processing time must be positive");
+    }
+    if (params.cycles != 0 && params.workers == 0)
+    {
+        throw std::invalid_argument("Cycles require workers");
+    }
+
+    std::mt19937_64 rng(params.seed);
+    std::uniform_int_distribution<TimeOffset> delivery_dist(1, params.max_delivery_interval);
+    std::uniform_int_distribution<TimeOffset> processing_dist(1, params.max_processing_time);
+    std::bernoulli_distribution lifo_dist(std::clamp(params.lifo_ratio, 0.0, 1.0));
+
+    WorkerLayers layers(params.workers, params.chain_depth);
+
+    writer << "; == LOADING RAMPS ==\n\n";
+    for (std::size_t i = 1; i <= params.ramps; ++i)
+    {
+        writer << "LOADING_RAMP id=" << i << " delivery-interval=" << delivery_dist(rng) << '\n';
+    }
+
+    writer << "; == WORKERS ==\n\n";
+    for (std::size_t i = 1; i <= params.workers; ++i)
+    {
+        writer << "WORKER id=" << i << " processing-time=" << processing_dist(rng) \
+            << " queue-type=" << (lifo_dist(rng) ? "LIFO" : "FIFO") << '\n';
+    }
+
+    writer << "; == STOREHOUSES ==\n\n";
+    for (std::size_t i = 1; i <= params.storehouses; ++i)
+    {
+        writer << "STOREHOUSE id=" << i << '\n';
+    }
+
+    /// Back links (worker index -> worker index), every such worker keeps its forward links as well
+    std::unordered_map<std::size_t, std::size_t> back_links;
+    if (params.workers != 0)
+    {
+        std::uniform_int_distribution<std::size_t> worker_dist(0, params.workers - 1);
+        std::size_t cycles = std::min(params.cycles, params.workers);
+        while (back_links.size() < cycles)
+        {
+            std::size_t worker = worker_dist(rng);
+            std::size_t layer_end = layers.layer_begin(layers.layer_of(worker) + 1);
+            back_links.emplace(worker, std::uniform_int_distribution<std::size_t>(0, layer_end - 1)(rng));
+        }
+    }
+
+    writer << "; == LINKS ==\n\n";
+    std::vector<std::size_t> receivers;
+    for (std::size_t i = 1; i <= params.ramps; ++i)
+    {
+        if (params.workers != 0)
+        {
+            sample_distinct(rng, 0, layers.layer_begin(1), params.fan_out, receivers);
+            for (std::size_t r : receivers) {writer << "LINK src=ramp-" << i << " dest=worker-" << r + 1 << '\n';}
+        }
+        else
+        {
+            sample_distinct(rng, 0, params.storehouses, params.fan_out, receivers);
+            for (std::size_t r : receivers) {writer << "LINK src=ramp-" << i << " dest=store-" << r + 1 << '\n';}
+        }
+        writer << '\n';
+    }
+
+    for (std::size_t w = 0; w < params.workers; ++w)
+    {
+        std::size_t layer = layers.layer_of(w);
+        if (layer + 1 < layers.depth())
+        {
+            std::size_t first = layers.layer_begin(layer + 1);
+            sample_distinct(rng, first, layers.layer_begin(layer + 2) - first, params.fan_out, receivers);
+            if (auto it = back_links.find(w); it != back_links.end())
+            {
+                receivers.push_back(it->second);
+            }
+            for (std::size_t r : receivers) {writer << "LINK src=worker-" << w + 1 << " dest=worker-" << r + 1 << '\n';}
+        }
+        else
+        {
+            if (auto it = back_links.find(w); it != back_links.end())
+            {
+                writer << "LINK src=worker-" << w + 1 << " dest=worker-" << it->second + 1 << '\n';
+            }
+            sample_distinct(rng, 0, params.storehouses, params.fan_out, receivers);
+            for (std::size_t r : receivers) {writer << "LINK src=worker-" << w + 1 << " dest=store-" << r + 1 << '\n';}
+        }
+        writer << '\n';
+    }
+
+    writer.flush();
+}
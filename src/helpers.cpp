@@ -1,4 +1,5 @@
 #include "helpers.hpp"
+#include "instrumentation.hpp"
 
 #include <cstdlib>
 #include <random>
@@ -11,6 +12,7 @@ std::mt19937 rng(rd());
 
 double default_probability_generator() {
     // Generuj liczby pseudolosowe z przedziału [0, 1); 10 bitów losowości.
+    INSTRUMENT_COUNT(RNG_DRAWS, 1);
     return std::generate_canonical<double, 10>(rng);
 }
 
@@ -0,0 +1,152 @@
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <string>
+
+constexpr const char* counter_names[] = {"packages_moved", "queue_pushes", "queue_pops", "rng_draws"};
+static_assert(std::size(counter_names) == static_cast<std::size_t>(InstrumentationCounter::COUNT));
+
+InstrumentationRecorder& instrumentation()
+{
+    static InstrumentationRecorder recorder;
+    return recorder;
+}
+
+void InstrumentationRecorder::enable(bool enabled, std::size_t max_events)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (enabled)
+    {
+        origin_ = clock::now();
+        maxEvents_ = max_events;
+        droppedEvents_ = 0;
+        events_.clear();
+        totals_.clear();
+        for (auto &counter : counters_)
+        {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+std::uint32_t InstrumentationRecorder::thread_index()
+{
+    static std::atomic<std::uint32_t> next_index{1};
+    thread_local std::uint32_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+void InstrumentationRecorder::record_phase(const char* name, clock::time_point start, clock::time_point end)
+{
+    std::uint32_t thread = thread_index();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    PhaseTotals& totals = totals_[name];
+    ++totals.calls;
+    totals.nanoseconds += static_cast<std::uint64_t>(duration);
+
+    if (events_.size() >= maxEvents_)
+    {
+        ++droppedEvents_;
+        return;
+    }
+    events_.push_back({name, std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin_).count(), duration, thread, {}});
+}
+
+void InstrumentationRecorder::sample_counters()
+{
+    std::uint32_t thread = thread_index();
+    auto now = clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (events_.size() >= maxEvents_)
+    {
+        ++droppedEvents_;
+        return;
+    }
+
+    Event event{nullptr, std::chrono::duration_cast<std::chrono::nanoseconds>(now - origin_).count(), 0, thread, {}};
+    for (std::size_t i = 0; i < counters_.size(); ++i)
+    {
+        event.counters[i] = counters_[i].load(std::memory_order_relaxed);
+    }
+    events_.push_back(event);
+}
+
+std::unordered_map<std::string_view, InstrumentationRecorder::PhaseTotals> InstrumentationRecorder::get_phase_totals() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totals_;
+}
+
+std::size_t InstrumentationRecorder::get_dropped_events() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return droppedEvents_;
+}
+
+/// Mikrosekundy z dokładnością do nanosekund
+void write_microseconds(std::ostream& os, std::int64_t nanoseconds)
+{
+    os << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000 << std::setfill(' ');
+}
+
+void InstrumentationRecorder::write_chrome_trace(std::ostream& os) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto &event : events_)
+    {
+        os << (first ? "\n" : ",\n");
+        first = false;
+        if (event.name != nullptr)
+        {
+            os << "{\"name\":\"" << event.name << "\",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":";
+            write_microseconds(os, event.start);
+            os << ",\"dur\":";
+            write_microseconds(os, event.duration);
+            os << "}";
+        }
+        else
+        {
+            os << "{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":";
+            write_microseconds(os, event.start);
+            os << ",\"args\":{";
+            for (std::size_t i = 0; i < event.counters.size(); ++i)
+            {
+                os << (i == 0 ? "" : ",") << '"' << counter_names[i] << "\":" << event.counters[i];
+            }
+            os << "}}";
+        }
+    }
+    os << "\n]}\n";
+    os.flush();
+}
+
+void InstrumentationRecorder::write_summary(std::ostream& os) const
+{
+    /// Fazy w kolejności alfabetycznej - powtarzalny wynik
+    std::map<std::string, PhaseTotals> phases;
+    for (const auto &[name, totals] : get_phase_totals())
+    {
+        phases.emplace(name, totals);
+    }
+
+    os << "== INSTRUMENTATION ==\n\n";
+    for (const auto &[name, totals] : phases)
+    {
+        os << name << ": " << totals.calls << " calls, " << static_cast<double>(totals.nanoseconds) / 1e6 << " ms\n";
+    }
+    for (std::size_t i = 0; i < counters_.size(); ++i)
+    {
+        os << counter_names[i] << ": " << counters_[i].load(std::memory_order_relaxed) << "\n";
+    }
+    if (std::size_t dropped = get_dropped_events(); dropped != 0)
+    {
+        os << "Events past the limit (totals only): " << dropped << "\n";
+    }
+    os.flush();
+}
@@ -0,0 +1,87 @@
+#include "memory_usage.hpp"
+#include "factory.hpp"
+
+#include <algorithm>
+
+void* CountingMemoryResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    void* p = upstream_->allocate(bytes, alignment);
+    bytesInUse_ += bytes;
+    peakBytes_ = std::max(peakBytes_, bytesInUse_);
+    ++allocations_;
+    return p;
+}
+
+void CountingMemoryResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+    upstream_->deallocate(p, bytes, alignment);
+    bytesInUse_ -= bytes;
+}
+
+
+MemoryUsage collect_memory_usage(const Factory& f)
+{
+    MemoryUsage usage;
+    std::for_each(f.ramp_cbegin(), f.ramp_cend(), [&usage](const Ramp& ramp)
+    {
+        std::size_t preferences = ramp.receiver_preferences_.get_memory_usage();
+        usage.ramps.push_back({ramp.get_id(), 0, preferences});
+        usage.preferences += preferences;
+    });
+    std::for_each(f.worker_cbegin(), f.worker_cend(), [&usage](const Worker& worker)
+    {
+        std::size_t queue = worker.get_queue()->get_memory_usage();
+        std::size_t preferences = worker.receiver_preferences_.get_memory_usage();
+        usage.workers.push_back({worker.get_id(), queue, preferences});
+        usage.queues += queue;
+        usage.preferences += preferences;
+    });
+    std::for_each(f.storehouse_cbegin(), f.storehouse_cend(), [&usage](const Storehouse& storehouse)
+    {
+        std::size_t stockpile = storehouse.get_stockpile()->get_memory_usage();
+        usage.storehouses.push_back({storehouse.get_id(), stockpile, 0});
+        usage.stockpiles += stockpile;
+    });
+
+    usage.node_collections = f.get_collections_memory_usage();
+    usage.package_ids = Package::get_id_sets_memory_usage() + (f.get_package_ledger() ? f.get_package_ledger()->get_memory_usage() : 0);
+    return usage;
+}
+
+void generate_memory_report(const MemoryUsage& usage, std::ostream& os, std::size_t max_nodes)
+{
+    os << "== MEMORY ==\n\n";
+    os << "Total: " << usage.total() << " bytes\n";
+    os << "  Node collections: " << usage.node_collections << "\n";
+    os << "  Worker queues: " << usage.queues << "\n";
+    os << "  Stockpiles: " << usage.stockpiles << "\n";
+    os << "  Receiver preferences: " << usage.preferences << "\n";
+    os << "  Package IDs (process-wide sets and ledger): " << usage.package_ids << "\n\n";
+
+    struct Entry
+    {
+        const char* type;
+        const NodeMemoryUsage* node;
+    };
+    std::vector<Entry> entries;
+    for (const auto& ramp : usage.ramps) {entries.push_back({"LOADING RAMP", &ramp});}
+    for (const auto& worker : usage.workers) {entries.push_back({"WORKER", &worker});}
+    for (const auto& storehouse : usage.storehouses) {entries.push_back({"STOREHOUSE", &storehouse});}
+
+    /// Największe najpierw, przy równych w kolejności fabryki
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+    {
+        return a.node->packages + a.node->preferences > b.node->packages + b.node->preferences;
+    });
+    if (max_nodes != 0 && entries.size() > max_nodes)
+    {
+        entries.resize(max_nodes);
+    }
+
+    for (const auto& entry : entries)
+    {
+        os << entry.type << " #" << entry.node->id << ": " << entry.node->packages + entry.node->preferences << " bytes";
+        os << " (packages " << entry.node->packages << ", preferences " << entry.node->preferences << ")\n";
+    }
+    os.flush();
+}
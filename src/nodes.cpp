@@ -1,7 +1,36 @@
 #include "nodes.hpp"
+#include "instrumentation.hpp"
+#include "package_handle.hpp"
+
+#include <algorithm>
 
 Storehouse::Storehouse(ElementID id, std::unique_ptr<IPackageStockpile> d): id_{id}, pStockpile_(std::move(d)) {}
 
+void Storehouse::receive_package(Package &&p)
+{
+    if (packageLedger_)
+    {
+        packageLedger_->retire(p);
+    }
+    ++receivedCount_;
+    if (statistics_)
+    {
+        ++storehouseStatistics_.packages_received;
+        storehouseStatistics_.latency.record(statistics_->get_time() - p.get_creation_time());
+    }
+    pStockpile_->push(std::move(p));
+}
+
+void Storehouse::receive_new_packages(std::size_t count)
+{
+    receivedCount_ += count;
+    if (statistics_)
+    {
+        storehouseStatistics_.packages_received += count;
+    }
+    pStockpile_->push_new(count);
+}
+
 void ReceiverPreferences::add_receiver(IPackageReceiver *packageReceiver)
 {
     preferences_.emplace(packageReceiver, 2);
@@ -16,6 +45,16 @@ void ReceiverPreferences::reassign_probability()
     {
         value = probability;
     }
+
+    receivers_.clear();
+    cumulative_.clear();
+    double sum_probability = 0;
+    for (auto [key, value] : preferences_)
+    {
+        sum_probability += value;
+        receivers_.push_back(key);
+        cumulative_.push_back(sum_probability);
+    }
 }
 
 void ReceiverPreferences::remove_receiver(IPackageReceiver *packageReceiver)
@@ -28,67 +67,127 @@ IPackageReceiver *ReceiverPreferences::choose_receiver()
 {
     if (!preferences_.empty())
     {
-        double random_number = probabilityGenerator_();
-        double sum_probability = 0;
-
-        for (auto [key, value]: preferences_)
-        {
-            sum_probability += value;
-            if (random_number < sum_probability) {return key;}
-        }
+        return choose_receiver(probabilityGenerator_());
     }
     return nullptr;
 }
 
+IPackageReceiver *ReceiverPreferences::choose_receiver(double u) const
+{
+    /// Pierwszy odbiorca, dla którego u < suma prawdopodobieństw
+    auto it = std::upper_bound(cumulative_.begin(), cumulative_.end(), u);
+    return it == cumulative_.end() ? nullptr : receivers_[static_cast<std::size_t>(it - cumulative_.begin())];
+}
 
-void PackageSender::push_package(Package &&package)
+std::size_t ReceiverPreferences::get_memory_usage() const
 {
-    buffer_.emplace(std::move(package));
+    return preferences_.size() * tree_node_bytes<preferences_t::value_type>
+           + receivers_.capacity() * sizeof(IPackageReceiver*) + cumulative_.capacity() * sizeof(double);
 }
 
-void PackageSender::send_package()
+bool ReceiverPreferences::has_default_generator() const
 {
-    if (buffer_)
-    {
-        receiver_preferences_.choose_receiver()->receive_package(std::move(buffer_.value()));
-        buffer_.reset();
-    }
+    auto function = probabilityGenerator_.target<double(*)()>();
+    return function != nullptr && *function == default_probability_generator;
 }
 
-void Ramp::deliver_goods(Time t)
+IPackageReceiver *ReceiverPreferences::choose_available_receiver()
 {
-    if (t % timeOffset_ == 0) /// Only if time increases by 1!
+    double available_probability = 0;
+    for (auto [key, value]: preferences_)
     {
-        send_package();
+        if (key->can_receive_package()) {available_probability += value;}
     }
-    else if(!get_sending_buffer().has_value())
+    if (available_probability <= 0)
+    {
+        return nullptr;
+    }
+
+    double random_number = probabilityGenerator_() * available_probability;
+    double sum_probability = 0;
+    IPackageReceiver* last_available = nullptr;
+    for (auto [key, value]: preferences_)
     {
-        push_package(Package());
+        if (!key->can_receive_package()) {continue;}
+        sum_probability += value;
+        last_available = key;
+        if (random_number < sum_probability) {return key;}
     }
+    return last_available;
 }
 
-Worker::Worker(ElementID id, TimeOffset pd, std::unique_ptr<IPackageQueue> q): id_{id}, timeOffset_{pd},
-                                                                                packageQueue_(std::move(q))
+
+void PackageSender::push_package(Package &&package)
 {
+    buffer_.emplace(std::move(package));
+}
 
+IPackageReceiver* PackageSender::send_package()
+{
+    if (buffer_)
+    {
+        return send_package(receiver_preferences_.choose_receiver());
+    }
+    return nullptr;
 }
 
-void Worker::do_work(Time t)
+IPackageReceiver* PackageSender::send_package(IPackageReceiver* receiver)
 {
-    if (!processing_buffer_.has_value())
+    if (!buffer_ || receiver == nullptr)
+    {
+        return nullptr;
+    }
+    if (!receiver->can_receive_package())
     {
-        processing_buffer_ = packageQueue_->pop();
-        processingStartTime_ = t;
+        if (statistics_)
+        {
+            ++senderStatistics_.blocked_sends;
+        }
+        if (receiver->get_backpressure_policy() == BackpressurePolicy::RETRY)
+        {
+            return nullptr;
+        }
+        receiver = receiver_preferences_.choose_available_receiver();
+        if (receiver == nullptr)
+        {
+            return nullptr;
+        }
+        if (statistics_)
+        {
+            ++senderStatistics_.rerouted_packages;
+        }
     }
-    if (t % timeOffset_ == 0)
+    receiver->receive_package(std::move(buffer_.value()));
+    buffer_.reset();
+    INSTRUMENT_COUNT(PACKAGES_MOVED, 1);
+    if (statistics_)
     {
-        push_package(std::move(processing_buffer_.value()));
-        processing_buffer_.reset();
+        ++senderStatistics_.packages_sent;
     }
+    return receiver;
+}
 
+IPackageReceiver* Ramp::deliver_goods(Time t, bool delivery_turn)
+{
+    if (delivery_turn) /// Only if time increases by 1!
+    {
+        return send_package();
+    }
+    else if(!get_sending_buffer().has_value())
+    {
+        Package package = packageLedger_ ? Package(packageLedger_->mint()) : Package();
+        if (statistics_)
+        {
+            package.set_creation_time(t);
+            ++rampStatistics_.deliveries;
+        }
+        push_package(std::move(package));
+    }
+    return nullptr;
 }
 
-void Worker::receive_package(Package &&package)
+Worker::Worker(ElementID id, TimeOffset pd, std::unique_ptr<IPackageQueue> q, std::size_t capacity, BackpressurePolicy policy):
+    WorkerBase<Worker>(id, pd, capacity, policy), packageQueue_(std::move(q))
 {
-    packageQueue_->push(std::move(package));
+
 }
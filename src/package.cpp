@@ -1,19 +1,36 @@
 #include "package.hpp"
+#include "memory_usage.hpp"
+#include "package_handle.hpp"
+
 #include <cassert>
 
-Package::Package()
+ElementID Package::acquire_id()
 {
+    ElementID id;
     if (freedIDs_.empty())
     {
-        ID_ = assignedIDs_.empty() ? 1 : *assignedIDs_.rbegin() + 1;
+        id = assignedIDs_.empty() ? 1 : *assignedIDs_.rbegin() + 1;
     }
     else
     {
-        ID_ = *freedIDs_.begin();
-        freedIDs_.erase(ID_);
+        id = *freedIDs_.begin();
+        freedIDs_.erase(id);
     }
 
-    assignedIDs_.insert(ID_);
+    assignedIDs_.insert(id);
+    return id;
+}
+
+void Package::release_id(ElementID id)
+{
+    assert(assignedIDs_.find(id) != assignedIDs_.end());
+    assignedIDs_.erase(id);
+    freedIDs_.insert(id);
+}
+
+Package::Package(): ID_{acquire_id()}
+{
+
 }
 
 Package::Package(ElementID id): ID_{id}
@@ -30,7 +47,12 @@ Package::Package(ElementID id): ID_{id}
     freedIDs_.erase(ID_);
 }
 
-Package::Package(Package &&other) noexcept: ID_{other.ID_}
+Package::Package(const PackageHandle &handle): ID_{handle.id}, creationTime_{handle.creation_time}, enqueueTime_{handle.enqueue_time}
+{
+    assert(ID_ == 0 || assignedIDs_.find(ID_) != assignedIDs_.end());
+}
+
+Package::Package(Package &&other) noexcept: ID_{other.ID_}, creationTime_{other.creationTime_}, enqueueTime_{other.enqueueTime_}
 {
     other.ID_ = 0;
 }
@@ -39,19 +61,33 @@ Package::~Package()
 {
     if (ID_ != 0)
     {
-        assert(assignedIDs_.find(ID_) != assignedIDs_.end());
-        assignedIDs_.erase(ID_);
-        freedIDs_.insert(ID_);
+        release_id(ID_);
     }
 }
 
 Package &Package::operator=(Package &&other) noexcept
 {
-    /// Zwolnienie ID przed przypisaniem
-    freedIDs_.insert(ID_);
-    assignedIDs_.erase(ID_);
+    /// Zwolnienie ID przed przypisaniem - przeniesiona paczka (ID 0) nie ma czego zwalniać
+    if (ID_ != 0)
+    {
+        release_id(ID_);
+    }
 
     ID_ = other.ID_;
+    creationTime_ = other.creationTime_;
+    enqueueTime_ = other.enqueueTime_;
     other.ID_ = 0;
     return *this;
 }
+
+PackageHandle Package::release()
+{
+    PackageHandle handle{ID_, creationTime_, enqueueTime_};
+    ID_ = 0;
+    return handle;
+}
+
+std::size_t Package::get_id_sets_memory_usage()
+{
+    return (assignedIDs_.size() + freedIDs_.size()) * tree_node_bytes<ElementID>;
+}
@@ -0,0 +1,173 @@
+#include "package_handle.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+PackageHandle PackageLedger::mint(Time creation_time)
+{
+    ElementID id = Package::acquire_id();
+    mark_live(id);
+    return {id, creation_time, 0};
+}
+
+void PackageLedger::mark_live(ElementID id)
+{
+    if (id > live_.size())
+    {
+        live_.resize(id);
+    }
+    if (!live_[id - 1])
+    {
+        live_[id - 1] = true;
+        ++liveCount_;
+    }
+}
+
+void PackageLedger::retire(const PackageHandle &package)
+{
+    if (!is_live(package.id))
+    {
+        throw std::logic_error("Package is not live in this ledger");
+    }
+    live_[package.id - 1] = false;
+    --liveCount_;
+    Package::release_id(package.id);
+}
+
+void PackageLedger::retire(const Package &package)
+{
+    if (!is_live(package.get_id()))
+    {
+        throw std::logic_error("Package is not live in this ledger");
+    }
+    live_[package.get_id() - 1] = false;
+    --liveCount_;
+}
+
+
+PackageHandleQueue::PackageHandleQueue(PackageQueueType packageQueueType, std::size_t initial_capacity, std::pmr::memory_resource* resource):
+    buffer_(resource), packageQueueType_{packageQueueType}
+{
+    reserve(std::max<std::size_t>(initial_capacity, 1));
+}
+
+void PackageHandleQueue::reserve(std::size_t capacity)
+{
+    std::size_t new_capacity = 1;
+    while (new_capacity < capacity)
+    {
+        new_capacity *= 2;
+    }
+    if (new_capacity <= capacity_)
+    {
+        return;
+    }
+
+    std::pmr::vector<PackageHandle> buffer(new_capacity, buffer_.get_allocator());
+    copy_out(0, size_, buffer.data());
+    buffer_ = std::move(buffer);
+    capacity_ = new_capacity;
+    head_ = 0;
+}
+
+void PackageHandleQueue::copy_out(std::size_t first, std::size_t count, PackageHandle *out) const
+{
+    if (count == 0)
+    {
+        return;
+    }
+    std::size_t begin = (head_ + first) & (capacity_ - 1);
+    std::size_t first_part = std::min(count, capacity_ - begin);
+    std::memcpy(out, buffer_.data() + begin, first_part * sizeof(PackageHandle));
+    std::memcpy(out + first_part, buffer_.data(), (count - first_part) * sizeof(PackageHandle));
+}
+
+void PackageHandleQueue::push(const PackageHandle &package)
+{
+    if (size_ == capacity_)
+    {
+        reserve(capacity_ * 2);
+    }
+    buffer_[(head_ + size_) & (capacity_ - 1)] = package;
+    ++size_;
+}
+
+PackageHandle PackageHandleQueue::pop()
+{
+    if (size_ == 0)
+    {
+        throw std::logic_error("Pop from an empty queue");
+    }
+    --size_;
+    if (packageQueueType_ == PackageQueueType::LIFO)
+    {
+        return buffer_[(head_ + size_) & (capacity_ - 1)];
+    }
+    PackageHandle package = buffer_[head_];
+    head_ = (head_ + 1) & (capacity_ - 1);
+    return package;
+}
+
+void PackageHandleQueue::push_bulk(const PackageHandle *packages, std::size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    reserve(size_ + count);
+    std::size_t end = (head_ + size_) & (capacity_ - 1);
+    std::size_t first_part = std::min(count, capacity_ - end);
+    std::memcpy(buffer_.data() + end, packages, first_part * sizeof(PackageHandle));
+    std::memcpy(buffer_.data(), packages + first_part, (count - first_part) * sizeof(PackageHandle));
+    size_ += count;
+}
+
+std::size_t PackageHandleQueue::pop_n(std::size_t n, PackageHandle *out)
+{
+    std::size_t count = std::min(n, size_);
+    if (packageQueueType_ == PackageQueueType::FIFO)
+    {
+        copy_out(0, count, out);
+        head_ = (head_ + count) & (capacity_ - 1);
+    }
+    else
+    {
+        /// Najnowsze na końcu bufora - kopiowanie i odwrócenie kolejności
+        copy_out(size_ - count, count, out);
+        std::reverse(out, out + count);
+    }
+    size_ -= count;
+    return count;
+}
+
+
+HandleStockpile::~HandleStockpile()
+{
+    for (std::size_t i = 0; i < handles_.size(); ++i)
+    {
+        Package::release_id(handles_[i].id);
+    }
+}
+
+void HandleStockpile::push_bulk(std::vector<Package> &&packages)
+{
+    std::vector<PackageHandle> handles;
+    handles.reserve(packages.size());
+    for (Package& package : packages)
+    {
+        handles.push_back(package.release());
+    }
+    handles_.push_bulk(handles.data(), handles.size());
+    packages.clear();
+}
+
+void HandleStockpile::push_new(std::size_t count)
+{
+    std::vector<PackageHandle> handles(count);
+    for (PackageHandle& handle : handles)
+    {
+        handle.id = Package::acquire_id();
+    }
+    handles_.push_bulk(handles.data(), handles.size());
+}
@@ -1,23 +1,43 @@
 #include "reports.hpp"
+#include "instrumentation.hpp"
 #include <queue>
+#include <vector>
 
 void generate_structure_report_ramp(const Ramp& ramp, std::ostream& os)
 {
     os << "LOADING RAMP #" << ramp.get_id() << "\n";
     os << "  Delivery interval: " << ramp.get_delivery_interval() << "\n";
     os << "  Receivers:\n";
+
+    /// Preferences are keyed by pointer - sorted by type and ID so the report does not depend on the heap layout
+    std::priority_queue<ElementID, std::vector<ElementID>, std::greater<>> id_workers;
+    std::priority_queue<ElementID, std::vector<ElementID>, std::greater<>> id_storehouses;
+
     for (auto [key, val] : ramp.receiver_preferences_)
     {
         switch (key->get_receiver_type())
         {
             case ReceiverType::WORKER:
-                os << "    worker #" << key->get_id() << "\n";
+                id_workers.push(key->get_id());
                 break;
             case ReceiverType::STOREHOUSE:
-                os << "    storehouse #" << key->get_id() << "\n";
+                id_storehouses.push(key->get_id());
                 break;
         }
     }
+
+    while (!id_workers.empty())
+    {
+        os << "    worker #" << id_workers.top() << "\n";
+        id_workers.pop();
+    }
+
+    while (!id_storehouses.empty())
+    {
+        os << "    storehouse #" << id_storehouses.top() << "\n";
+        id_storehouses.pop();
+    }
+
     os << std::endl;
 }
 
@@ -61,6 +81,7 @@ void generate_structure_report_worker(const Worker& worker, std::ostream& os)
 
 void generate_structure_report(const Factory& f, std::ostream& os)
 {
+    INSTRUMENT_SCOPE("structure_report");
     os << "\n== LOADING RAMPS ==\n\n";
     std::for_each(f.ramp_cbegin(), f.ramp_cend(), [&os](const Ramp& ramp){ generate_structure_report_ramp(ramp, os);});
 
@@ -75,69 +96,144 @@ void generate_structure_report(const Factory& f, std::ostream& os)
     os.flush();
 }
 
-void generate_simulation_turn_report_worker(const Worker& worker, std::ostream& os)
+void generate_simulation_turn_report_packages(IPackageStockpile::const_iterator begin, IPackageStockpile::const_iterator end, BufferedWriter& writer)
 {
-    os << "WORKER #" << worker.get_id() << "\n";
-    os << "  PBuffer: ";
+    if (begin == end)
+    {
+        writer << "(empty)";
+    }
+    for (auto iter = begin; iter != end; ++iter)
+    {
+        if (iter != begin)
+        {
+            writer << ", ";
+        }
+        writer << '#' << iter->get_id();
+    }
+}
+
+void generate_simulation_turn_report_worker(const Worker& worker, BufferedWriter& writer)
+{
+    writer << "WORKER #" << worker.get_id() << "\n";
+    writer << "  PBuffer: ";
 
     if (worker.get_processing_buffer().has_value())
     {
-        os << "#" << std::to_string(worker.get_processing_buffer()->get_id());
-        os << " (pt = " << worker.get_package_processing_start_time() << ")\n";
+        writer << '#' << worker.get_processing_buffer()->get_id();
+        writer << " (pt = " << worker.get_package_processing_start_time() << ")\n";
     }
     else
     {
-        os << "(empty)\n";
+        writer << "(empty)\n";
     }
 
+    writer << "  Queue: ";
+    generate_simulation_turn_report_packages(worker.get_queue()->begin(), worker.get_queue()->end(), writer);
+    writer << "\n";
 
-    os << "  Queue: ";
-    if (worker.get_queue()->begin() == worker.get_queue()->end())
+    writer << "  SBuffer: ";
+    if (worker.get_sending_buffer().has_value())
     {
-        os << "(empty)";
+        writer << '#' << worker.get_sending_buffer()->get_id();
     }
-    for (auto iter = worker.get_queue()->begin(); iter != worker.get_queue()->end(); ++iter)
+    else
     {
-        os << "#" << iter->get_id();
-        if (std::next(iter) != worker.get_queue()->end())
-        {
-            os << ", ";
-        }
+        writer << "(empty)";
     }
-    os << "\n";
+    writer << "\n\n";
+}
 
-    os << "  SBuffer: " << (worker.get_sending_buffer() ? "#" + std::to_string(worker.get_sending_buffer().value().get_id()) : "(empty)");
-    os << "\n";
-    os << std::endl;
+void generate_simulation_turn_report_storehouse(const Storehouse& storehouse, BufferedWriter& writer)
+{
+    writer << "STOREHOUSE #" << storehouse.get_id() << "\n";
+    writer << "  Stock: ";
+    generate_simulation_turn_report_packages(storehouse.cbegin(), storehouse.cend(), writer);
+    writer << "\n";
 }
 
-void generate_simulation_turn_report_storehouse(const Storehouse& storehouse, std::ostream& os)
+void generate_simulation_turn_report(const Factory& f, BufferedWriter& writer, Time t)
 {
-    os << "STOREHOUSE #" << storehouse.get_id() << "\n";
-    os << "  Stock: ";
-    if (storehouse.cbegin() == storehouse.cend())
-    {
-        os << "(empty)";
-    }
-    for (auto iter = storehouse.cbegin(); iter != storehouse.cend(); ++iter)
+    INSTRUMENT_SCOPE("turn_report");
+    writer << "=== [ Turn: " << t << " ] ===\n\n";
+
+    writer << "== WORKERS ==\n\n";
+    std::for_each(f.worker_cbegin(), f.worker_cend(), [&writer](const Worker& worker){ generate_simulation_turn_report_worker(worker, writer);});
+
+    writer << "\n== STOREHOUSES ==\n\n";
+    std::for_each(f.storehouse_cbegin(), f.storehouse_cend(), [&writer](const Storehouse& storehouse){ generate_simulation_turn_report_storehouse(storehouse, writer);});
+    writer << "\n";
+
+    /// Jedyny flush w raporcie - na granicy tury
+    writer.flush();
+}
+
+void generate_simulation_turn_report(const Factory& f, std::ostream& os, Time t)
+{
+    BufferedWriter writer(os);
+    generate_simulation_turn_report(f, writer, t);
+}
+
+void generate_simulation_turn_delta_report(const Factory& f, BufferedWriter& writer, Time t)
+{
+    INSTRUMENT_SCOPE("turn_delta_report");
+    std::vector<const Worker*> workers;
+    std::vector<const Storehouse*> storehouses;
+    for (const IPackageReceiver* receiver : f.get_changed_receivers())
     {
-        os << "#" << iter->get_id();
-        if (std::next(iter) != storehouse.cend())
+        switch (receiver->get_receiver_type())
         {
-            os << ", ";
+            case ReceiverType::WORKER:
+                workers.push_back(static_cast<const Worker*>(receiver));
+                break;
+            case ReceiverType::STOREHOUSE:
+                storehouses.push_back(static_cast<const Storehouse*>(receiver));
+                break;
         }
     }
-    os << std::endl;
+
+    auto by_id = [](const auto* lhs, const auto* rhs){return lhs->get_id() < rhs->get_id();};
+    std::sort(workers.begin(), workers.end(), by_id);
+    std::sort(storehouses.begin(), storehouses.end(), by_id);
+
+    writer << "=== [ Turn: " << t << " (changes) ] ===\n\n";
+
+    writer << "== WORKERS ==\n\n";
+    for (const Worker* worker : workers)
+    {
+        generate_simulation_turn_report_worker(*worker, writer);
+    }
+
+    writer << "\n== STOREHOUSES ==\n\n";
+    for (const Storehouse* storehouse : storehouses)
+    {
+        generate_simulation_turn_report_storehouse(*storehouse, writer);
+    }
+    writer << "\n";
+
+    writer.flush();
 }
 
-void generate_simulation_turn_report(const Factory& f, std::ostream& os, Time t)
-{
-    os << "=== [ Turn: " << t << " ] ===\n\n";
+DeltaTurnReporter::DeltaTurnReporter(std::ostream &os, TimeOffset keyframe_interval): writer_(os), keyframeInterval_{std::max<TimeOffset>(keyframe_interval, 1)} {}
 
-    os << "== WORKERS ==\n\n";
-    std::for_each(f.worker_cbegin(), f.worker_cend(), [&os](const Worker& worker){ generate_simulation_turn_report_worker(worker, os);});
+void DeltaTurnReporter::operator()(Factory &f, Time t)
+{
+    if (!f.is_change_tracking() || turnsSinceKeyframe_ + 1 >= keyframeInterval_)
+    {
+        generate_simulation_turn_report(f, writer_, t);
+        turnsSinceKeyframe_ = 0;
+    }
+    else
+    {
+        generate_simulation_turn_delta_report(f, writer_, t);
+        ++turnsSinceKeyframe_;
+    }
 
-    os << "\n== STOREHOUSES ==\n\n";
-    std::for_each(f.storehouse_cbegin(), f.storehouse_cend(), [&os](const Storehouse& storehouse){ generate_simulation_turn_report_storehouse(storehouse, os);});
-    os << std::endl;
-}
\ No newline at end of file
+    if (f.is_change_tracking())
+    {
+        f.clear_changed_receivers();
+    }
+    else
+    {
+        f.set_change_tracking(true);
+    }
+}
@@ -0,0 +1,152 @@
+#include "scheduler.hpp"
+
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SYMULACJASIECI_X86
+#include <immintrin.h>
+#endif
+
+/// Decrements countdowns [begin, n); fired ones are reloaded with their period and reported
+void countdown_scalar(std::int32_t* countdowns, const std::int32_t* periods, std::size_t begin, std::size_t n,
+                      std::vector<std::uint32_t>& fired)
+{
+    for (std::size_t i = begin; i < n; ++i)
+    {
+        if (--countdowns[i] == 0)
+        {
+            countdowns[i] = periods[i];
+            fired.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+}
+
+void report_fired(unsigned mask, std::size_t base, std::vector<std::uint32_t>& fired)
+{
+    while (mask != 0)
+    {
+        fired.push_back(static_cast<std::uint32_t>(base + static_cast<std::size_t>(__builtin_ctz(mask))));
+        mask &= mask - 1;
+    }
+}
+
+#ifdef SYMULACJASIECI_X86
+__attribute__((target("sse2")))
+void countdown_sse2(std::int32_t* countdowns, const std::int32_t* periods, std::size_t n, std::vector<std::uint32_t>& fired)
+{
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i c = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(countdowns + i)), one);
+        __m128i fire = _mm_cmpeq_epi32(c, zero);
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(periods + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(countdowns + i), _mm_add_epi32(c, _mm_and_si128(fire, p)));
+        report_fired(static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(fire))), i, fired);
+    }
+    countdown_scalar(countdowns, periods, i, n, fired);
+}
+
+__attribute__((target("avx2")))
+void countdown_avx2(std::int32_t* countdowns, const std::int32_t* periods, std::size_t n, std::vector<std::uint32_t>& fired)
+{
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i zero = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i c = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(countdowns + i)), one);
+        __m256i fire = _mm256_cmpeq_epi32(c, zero);
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(periods + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(countdowns + i), _mm256_add_epi32(c, _mm256_and_si256(fire, p)));
+        report_fired(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(fire))), i, fired);
+    }
+    countdown_scalar(countdowns, periods, i, n, fired);
+}
+#endif
+
+bool CountdownScheduler::is_supported(SchedulerKernel kernel)
+{
+    switch (kernel)
+    {
+        case SchedulerKernel::AUTO:
+        case SchedulerKernel::SCALAR:
+            return true;
+#ifdef SYMULACJASIECI_X86
+        case SchedulerKernel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case SchedulerKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#else
+        case SchedulerKernel::SSE2:
+        case SchedulerKernel::AVX2:
+            return false;
+#endif
+    }
+    return false;
+}
+
+CountdownScheduler::CountdownScheduler(SchedulerKernel kernel): kernel_{kernel}
+{
+    if (!is_supported(kernel))
+    {
+        throw std::invalid_argument("Scheduler kernel not supported by the CPU");
+    }
+    if (kernel_ == SchedulerKernel::AUTO)
+    {
+        kernel_ = is_supported(SchedulerKernel::AVX2) ? SchedulerKernel::AVX2
+                : is_supported(SchedulerKernel::SSE2) ? SchedulerKernel::SSE2 : SchedulerKernel::SCALAR;
+    }
+}
+
+void CountdownScheduler::set_periods(const std::vector<TimeOffset>& periods)
+{
+    for (TimeOffset period : periods)
+    {
+        if (period < 1)
+        {
+            throw std::invalid_argument("Periods must be positive");
+        }
+    }
+    periods_.assign(periods.begin(), periods.end());
+    countdowns_.assign(periods_.size(), 0);
+    synced_ = false;
+}
+
+void CountdownScheduler::resync(Time t)
+{
+    /// Następne odpalenie w turze t - 1 + countdown (pierwsza wielokrotność okresu >= t)
+    for (std::size_t i = 0; i < periods_.size(); ++i)
+    {
+        std::int32_t previous = ((t - 1) % periods_[i] + periods_[i]) % periods_[i];
+        countdowns_[i] = periods_[i] - previous;
+    }
+    synced_ = true;
+}
+
+const std::vector<std::uint32_t>& CountdownScheduler::advance(Time t)
+{
+    if (!synced_ || t != last_ + 1)
+    {
+        resync(t);
+    }
+    last_ = t;
+
+    fired_.clear();
+    switch (kernel_)
+    {
+#ifdef SYMULACJASIECI_X86
+        case SchedulerKernel::AVX2:
+            countdown_avx2(countdowns_.data(), periods_.data(), countdowns_.size(), fired_);
+            break;
+        case SchedulerKernel::SSE2:
+            countdown_sse2(countdowns_.data(), periods_.data(), countdowns_.size(), fired_);
+            break;
+#endif
+        default:
+            countdown_scalar(countdowns_.data(), periods_.data(), 0, countdowns_.size(), fired_);
+            break;
+    }
+    return fired_;
+}
@@ -0,0 +1,321 @@
+#include "server.hpp"
+
+#include "flow.hpp"
+#include "memory_usage.hpp"
+#include "reports.hpp"
+#include "statistics.hpp"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+bool SimulationSession::handle_line(const std::string& line, std::ostream& out)
+{
+    if (patch_)
+    {
+        if (line != "END")
+        {
+            *patch_ += line;
+            *patch_ += '\n';
+            return true;
+        }
+        std::istringstream patch(*patch_);
+        patch_.reset();
+        try
+        {
+            apply_factory_patch(factory_, patch);
+            out << "OK\n";
+        }
+        catch (std::exception& err)
+        {
+            out << "ERROR " << err.what() << "\n";
+        }
+        return true;
+    }
+
+    std::size_t idx = line.find(' ');
+    std::string command = line.substr(0, idx);
+    std::string arguments = idx == std::string::npos ? std::string() : line.substr(idx + 1);
+
+    if (command == "SHUTDOWN")
+    {
+        out << "OK\n";
+        return false;
+    }
+    if (command == "PATCH")
+    {
+        patch_.emplace();
+        return true;
+    }
+
+    try
+    {
+        handle_command(command, arguments, out);
+        out << "OK\n";
+    }
+    catch (std::exception& err)
+    {
+        out << "ERROR " << err.what() << "\n";
+    }
+    return true;
+}
+
+void SimulationSession::handle_command(const std::string& command, const std::string& arguments, std::ostream& out)
+{
+    if (command == "SIMULATE")
+    {
+        TimeOffset turns = 0;
+        const char* last = arguments.data() + arguments.size();
+        auto [end, error] = std::from_chars(arguments.data(), last, turns);
+        if (error != std::errc() || end != last || turns < 0)
+        {
+            throw std::invalid_argument("Invalid number of turns: " + arguments);
+        }
+        if (turns > std::numeric_limits<Time>::max() - time_)
+        {
+            throw std::invalid_argument("Number of turns exceeds the time range: " + arguments);
+        }
+        if (!factory_.is_consistent())
+        {
+            throw std::logic_error("Factory is not consistent");
+        }
+        for (Time end = time_ + turns; time_ < end;)
+        {
+            ++time_;
+            factory_.do_deliveries(time_);
+            factory_.do_package_passing();
+            factory_.do_work(time_);
+        }
+        out << "TURN " << time_ << "\n";
+    }
+    else if (command == "STATISTICS")
+    {
+        if (arguments == "ON" || arguments == "OFF")
+        {
+            factory_.enable_statistics(arguments == "ON");
+        }
+        else if (!factory_.has_statistics())
+        {
+            throw std::logic_error("Statistics are disabled");
+        }
+        else
+        {
+            generate_statistics_report(collect_statistics(factory_), out);
+        }
+    }
+    else if (command == "REPORT")
+    {
+        generate_simulation_turn_report(factory_, out, time_);
+    }
+    else if (command == "FLOW")
+    {
+        generate_flow_report(estimate_flow(factory_), out);
+    }
+    else if (command == "MEMORY")
+    {
+        generate_memory_report(collect_memory_usage(factory_), out);
+    }
+    else if (command == "SAVE")
+    {
+        if (arguments.empty())
+        {
+            save_factory_structure(factory_, out);
+        }
+        else
+        {
+            save_factory_structure(factory_, arguments);
+        }
+    }
+    else
+    {
+        throw std::invalid_argument("Unknown command " + command);
+    }
+}
+
+
+/// Gniazdo zamykane przy wyjściu z zakresu
+class SocketHandle
+{
+public:
+    explicit SocketHandle(int fd): fd_{fd} {}
+    SocketHandle(SocketHandle&& other) noexcept: fd_{other.fd_} {other.fd_ = -1;}
+    SocketHandle(const SocketHandle&) = delete;
+    SocketHandle& operator=(const SocketHandle&) = delete;
+    ~SocketHandle() {if (fd_ >= 0) {::close(fd_);}}
+
+    [[nodiscard]] int get() const {return fd_;}
+
+private:
+    int fd_;
+};
+
+void write_all(int fd, const std::string& data)
+{
+    std::size_t written = 0;
+    while (written < data.size())
+    {
+        ssize_t result = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (result < 0)
+        {
+            if (errno == EINTR) {continue;}
+            throw std::system_error(errno, std::generic_category(), "Cannot write to the client");
+        }
+        written += static_cast<std::size_t>(result);
+    }
+}
+
+SocketHandle listen_on(const std::string& socket_path)
+{
+    sockaddr_un address{};
+    if (socket_path.size() >= sizeof(address.sun_path))
+    {
+        throw std::invalid_argument("Socket path too long: " + socket_path);
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    SocketHandle server(::socket(AF_UNIX, SOCK_STREAM, 0));
+    if (server.get() < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot create a socket");
+    }
+    /// Tylko pozostałe gniazdo jest usuwane - nigdy zwykły plik podany jako ścieżka
+    struct stat status{};
+    if (::lstat(socket_path.c_str(), &status) == 0)
+    {
+        if (!S_ISSOCK(status.st_mode))
+        {
+            throw std::invalid_argument("Not a socket: " + socket_path);
+        }
+        ::unlink(socket_path.c_str());
+    }
+    if (::bind(server.get(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(server.get(), 8) < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot listen on " + socket_path);
+    }
+    return server;
+}
+
+void serve_on(SimulationSession& session, SocketHandle server, const std::string& socket_path);
+
+/// Returns false when the session was shut down, true when the client disconnected
+bool serve_client(SimulationSession& session, int client, int server)
+{
+    std::string input;
+    char buffer[4096];
+    while (true)
+    {
+        for (std::size_t end = input.find('\n'); end != std::string::npos; end = input.find('\n'))
+        {
+            std::string line = input.substr(0, end);
+            input.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+
+            if (line == "QUIT")
+            {
+                write_all(client, "OK\n");
+                return true;
+            }
+            if (line.rfind("FORK ", 0) == 0)
+            {
+                /// Gniazdo kopii nasłuchuje już przed odpowiedzią - klient może się z nim od razu połączyć
+                std::string fork_path = line.substr(5);
+                std::optional<SocketHandle> fork_server;
+                try
+                {
+                    fork_server.emplace(listen_on(fork_path));
+                }
+                catch (std::exception& err)
+                {
+                    write_all(client, "ERROR " + std::string(err.what()) + "\n");
+                    continue;
+                }
+
+                pid_t pid = ::fork();
+                if (pid == 0)
+                {
+                    ::close(client);
+                    ::close(server);
+                    int status = 0;
+                    try
+                    {
+                        serve_on(session, std::move(*fork_server), fork_path);
+                    }
+                    catch (...)
+                    {
+                        status = 1;
+                    }
+                    ::_exit(status);
+                }
+                if (pid < 0)
+                {
+                    int error = errno;
+                    ::unlink(fork_path.c_str());
+                    write_all(client, "ERROR " + std::string(std::strerror(error)) + "\n");
+                }
+                else
+                {
+                    write_all(client, "PID " + std::to_string(pid) + "\nOK\n");
+                }
+                continue;
+            }
+
+            std::ostringstream response;
+            bool running = session.handle_line(line, response);
+            write_all(client, response.str());
+            if (!running)
+            {
+                return false;
+            }
+        }
+
+        ssize_t received = ::recv(client, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received <= 0)
+        {
+            return true;
+        }
+        input.append(buffer, static_cast<std::size_t>(received));
+    }
+}
+
+void serve_on(SimulationSession& session, SocketHandle server, const std::string& socket_path)
+{
+    bool running = true;
+    while (running)
+    {
+        SocketHandle client(::accept(server.get(), nullptr, nullptr));
+        if (client.get() < 0)
+        {
+            if (errno == EINTR) {continue;}
+            throw std::system_error(errno, std::generic_category(), "Cannot accept a connection");
+        }
+        running = serve_client(session, client.get(), server.get());
+    }
+    ::unlink(socket_path.c_str());
+}
+
+void serve_session(SimulationSession& session, const std::string& socket_path)
+{
+    /// Zakończone kopie (FORK) nie zostają jako procesy zombie
+    std::signal(SIGCHLD, SIG_IGN);
+
+    serve_on(session, listen_on(socket_path), socket_path);
+}
@@ -0,0 +1,73 @@
+#include "simulation.hpp"
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+SimulationSummary simulate(Factory& f, TimeOffset d, std::function<void(Factory&, Time)> rf)
+{
+    return simulate(f, d, std::move(rf), SimulationOptions());
+}
+
+SimulationSummary simulate(Factory& f, TimeOffset d, std::function<void(Factory&, Time)> rf, const SimulationOptions& options)
+{
+    if (!f.is_consistent())
+    {
+        throw std::logic_error("Factory is not consistent");
+    }
+    if (options.skip_ahead < 0)
+    {
+        throw std::invalid_argument("Skip-ahead cannot be negative");
+    }
+    if (options.skip_ahead > 0 && options.convergence)
+    {
+        throw std::invalid_argument("Skip-ahead cannot be combined with convergence detection");
+    }
+
+    std::optional<ConvergenceMonitor> monitor;
+    if (options.convergence)
+    {
+        monitor.emplace(*options.convergence);
+    }
+
+    SimulationSummary summary;
+    for (Time t = 1; options.skip_ahead > 0 && t <= d; t += options.skip_ahead)
+    {
+        TimeOffset turns = std::min(options.skip_ahead, d - t + 1);
+        f.advance(t, turns);
+        summary.turns = t + turns - 1;
+        INSTRUMENT_SAMPLE_COUNTERS();
+        INSTRUMENT_SCOPE("report");
+        rf(f, summary.turns);
+    }
+
+    for (Time t = 1; options.skip_ahead == 0 && t <= d; ++t)
+    {
+        f.do_deliveries(t);
+        f.do_package_passing();
+        f.do_work(t);
+        INSTRUMENT_SAMPLE_COUNTERS();
+        {
+            INSTRUMENT_SCOPE("report");
+            rf(f, t);
+        }
+        summary.turns = t;
+
+        if (monitor)
+        {
+            summary.stop_reason = monitor->observe(f, t);
+            if (summary.stop_reason != StopReason::COMPLETED)
+            {
+                summary.diverging_worker = monitor->get_diverging_worker();
+                break;
+            }
+        }
+    }
+
+    if (f.has_statistics())
+    {
+        summary.statistics = collect_statistics(f);
+    }
+    return summary;
+}
@@ -0,0 +1,148 @@
+#include "statistics.hpp"
+#include "factory.hpp"
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+std::size_t LatencyHistogram::bucket_index(std::uint32_t value)
+{
+    if (value < 2 * sub_buckets)
+    {
+        return value;
+    }
+    unsigned exponent = 31U - static_cast<unsigned>(__builtin_clz(value));
+    unsigned shift = exponent - sub_bucket_bits;
+    return sub_buckets * (shift + 1) + ((value >> shift) & (sub_buckets - 1));
+}
+
+std::uint32_t LatencyHistogram::bucket_upper_bound(std::size_t index)
+{
+    if (index < 2 * sub_buckets)
+    {
+        return static_cast<std::uint32_t>(index);
+    }
+    auto shift = static_cast<unsigned>(index / sub_buckets - 1);
+    auto mantissa = static_cast<std::uint64_t>(sub_buckets + index % sub_buckets);
+    return static_cast<std::uint32_t>(((mantissa + 1) << shift) - 1);
+}
+
+void LatencyHistogram::record(Time value)
+{
+    auto index = bucket_index(static_cast<std::uint32_t>(std::max<Time>(value, 0)));
+    if (index >= buckets_.size())
+    {
+        buckets_.resize(index + 1);
+    }
+    ++buckets_[index];
+    ++count_;
+    max_ = std::max(max_, value);
+}
+
+Time LatencyHistogram::percentile(double quantile) const
+{
+    if (count_ == 0)
+    {
+        return 0;
+    }
+
+    auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count_)));
+    rank = std::max<std::uint64_t>(rank, 1);
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets_.size(); ++i)
+    {
+        seen += buckets_[i];
+        if (seen >= rank)
+        {
+            return std::min(static_cast<Time>(bucket_upper_bound(i)), max_);
+        }
+    }
+    return max_;
+}
+
+LatencySummary summarize_latency(const LatencyHistogram& histogram)
+{
+    return {histogram.percentile(0.5), histogram.percentile(0.99), histogram.percentile(0.999), histogram.max()};
+}
+
+void generate_latency_report(const char* label, const LatencySummary& latency, std::ostream& os)
+{
+    os << "  " << label << ": p50 " << latency.p50 << ", p99 " << latency.p99 << ", p999 " << latency.p999 << ", max " << latency.max << "\n";
+}
+
+StatisticsSummary collect_statistics(const Factory& f)
+{
+    INSTRUMENT_SCOPE("collect_statistics");
+    if (!f.has_statistics())
+    {
+        throw std::logic_error("Statistics are not enabled");
+    }
+
+    StatisticsSummary summary;
+    summary.turns = f.get_statistics_collector()->get_turns();
+    double turns = summary.turns > 0 ? static_cast<double>(summary.turns) : 1.0;
+
+    std::for_each(f.ramp_cbegin(), f.ramp_cend(), [&summary](const Ramp& ramp)
+    {
+        const SenderStatistics& sender = ramp.get_sender_statistics();
+        summary.ramps.push_back({ramp.get_id(), ramp.get_statistics().deliveries, sender.packages_sent,
+                                 sender.blocked_sends, sender.rerouted_packages});
+    });
+
+    std::for_each(f.worker_cbegin(), f.worker_cend(), [&summary](const Worker& worker)
+    {
+        const WorkerStatistics& stats = worker.get_statistics();
+        const SenderStatistics& sender = worker.get_sender_statistics();
+        std::uint64_t samples = stats.busy_turns + stats.idle_turns;
+        double divisor = samples > 0 ? static_cast<double>(samples) : 1.0;
+        summary.workers.push_back({worker.get_id(), stats.busy_turns, stats.idle_turns,
+                                   static_cast<double>(stats.busy_turns) / divisor,
+                                   static_cast<double>(stats.queue_length_sum) / divisor,
+                                   stats.queue_length_max, sender.packages_sent, sender.blocked_sends,
+                                   sender.rerouted_packages, stats.full_turns, summarize_latency(stats.queue_wait)});
+    });
+
+    std::for_each(f.storehouse_cbegin(), f.storehouse_cend(), [&summary, turns](const Storehouse& storehouse)
+    {
+        std::uint64_t received = storehouse.get_statistics().packages_received;
+        summary.storehouses.push_back({storehouse.get_id(), received, static_cast<double>(received) / turns,
+                                       summarize_latency(storehouse.get_statistics().latency)});
+    });
+
+    return summary;
+}
+
+void generate_statistics_report(const StatisticsSummary& summary, std::ostream& os)
+{
+    INSTRUMENT_SCOPE("statistics_report");
+    os << "== STATISTICS ==\n\n";
+    os << "Turns: " << summary.turns << "\n\n";
+
+    for (const auto& ramp : summary.ramps)
+    {
+        os << "LOADING RAMP #" << ramp.id << "\n";
+        os << "  Deliveries: " << ramp.deliveries << "\n";
+        os << "  Sent: " << ramp.packages_sent << " (blocked " << ramp.blocked_sends << ", rerouted " << ramp.rerouted_packages << ")\n";
+    }
+
+    for (const auto& worker : summary.workers)
+    {
+        os << "WORKER #" << worker.id << "\n";
+        os << "  Utilization: " << worker.utilization << " (busy " << worker.busy_turns << ", idle " << worker.idle_turns << ")\n";
+        os << "  Queue length: mean " << worker.queue_length_mean << ", max " << worker.queue_length_max << "\n";
+        os << "  Queue full: " << worker.full_turns << " turns\n";
+        os << "  Sent: " << worker.packages_sent << " (blocked " << worker.blocked_sends << ", rerouted " << worker.rerouted_packages << ")\n";
+        generate_latency_report("Queue wait", worker.queue_wait, os);
+    }
+
+    for (const auto& storehouse : summary.storehouses)
+    {
+        os << "STOREHOUSE #" << storehouse.id << "\n";
+        os << "  Received: " << storehouse.packages_received << "\n";
+        os << "  Throughput: " << storehouse.throughput << " per turn\n";
+        generate_latency_report("Latency", storehouse.latency, os);
+    }
+    os.flush();
+}
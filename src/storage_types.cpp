@@ -1,12 +1,55 @@
 #include "storage_types.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
+void IPackageStockpile::push_bulk(std::vector<Package> &&packages)
+{
+    for (auto &package : packages)
+    {
+        push(std::move(package));
+    }
+    packages.clear();
+}
+
+void IPackageStockpile::push_new(std::size_t count)
+{
+    for (; count > 0; --count)
+    {
+        push(Package());
+    }
+}
+
+std::size_t IPackageQueue::pop_n(std::size_t n, std::vector<Package> &out)
+{
+    std::size_t count = std::min(n, size());
+    out.reserve(out.size() + count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        out.push_back(pop());
+    }
+    return count;
+}
+
+std::size_t IPackageQueue::drain_into(IPackageStockpile &target)
+{
+    std::size_t count = size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        target.push(pop());
+    }
+    return count;
+}
+
 void PackageQueue::push(Package &&package)
 {
+    INSTRUMENT_COUNT(QUEUE_PUSHES, 1);
     packageList_.emplace_back(std::move(package));
 }
 
 Package PackageQueue::pop()
 {
+    INSTRUMENT_COUNT(QUEUE_POPS, 1);
     Package deletedPackage;
     switch (packageQueueType_)
     {
@@ -22,3 +65,73 @@ Package PackageQueue::pop()
     }
     return deletedPackage;
 }
+
+void PackageQueue::push_bulk(std::vector<Package> &&packages)
+{
+    INSTRUMENT_COUNT(QUEUE_PUSHES, packages.size());
+    for (auto &package : packages)
+    {
+        packageList_.emplace_back(std::move(package));
+    }
+    packages.clear();
+}
+
+std::size_t PackageQueue::pop_n(std::size_t n, std::vector<Package> &out)
+{
+    std::size_t count = std::min(n, packageList_.size());
+    INSTRUMENT_COUNT(QUEUE_POPS, count);
+    out.reserve(out.size() + count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (packageQueueType_ == PackageQueueType::FIFO)
+        {
+            out.push_back(std::move(packageList_.front()));
+            packageList_.pop_front();
+        }
+        else
+        {
+            out.push_back(std::move(packageList_.back()));
+            packageList_.pop_back();
+        }
+    }
+    return count;
+}
+
+std::size_t PackageQueue::drain_into(IPackageStockpile &target)
+{
+    auto queue = dynamic_cast<PackageQueue*>(&target);
+    if (queue == nullptr || queue == this || queue->packageList_.get_allocator() != packageList_.get_allocator())
+    {
+        return IPackageQueue::drain_into(target);
+    }
+
+    std::size_t count = packageList_.size();
+    /// Kolejność pobierania LIFO to odwrócona lista
+    if (packageQueueType_ == PackageQueueType::LIFO)
+    {
+        packageList_.reverse();
+    }
+    queue->packageList_.splice(queue->packageList_.end(), packageList_);
+    return count;
+}
+
+RingStockpile::RingStockpile(std::size_t capacity, std::pmr::memory_resource* resource): packageList_(resource), capacity_{capacity}
+{
+    if (capacity_ == 0)
+    {
+        throw std::invalid_argument("Ring stockpile capacity must be positive");
+    }
+}
+
+void RingStockpile::push(Package &&package)
+{
+    if (packageList_.size() < capacity_)
+    {
+        packageList_.emplace_back(std::move(package));
+        return;
+    }
+
+    /// Nadpisanie najstarszej paczki i przeniesienie jej węzła na koniec
+    packageList_.front() = std::move(package);
+    packageList_.splice(packageList_.end(), packageList_, packageList_.begin());
+}
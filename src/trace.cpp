@@ -0,0 +1,143 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+constexpr char trace_magic[] = {'S', 'S', 'T', 'R', 'A', 'C', 'E', '1'};
+
+void TraceChunk::clear()
+{
+    times.clear();
+    queue_lengths.clear();
+    processing_buffers.clear();
+    sending_buffers.clear();
+    stock_counts.clear();
+}
+
+
+TraceWriter::TraceWriter(const std::string &path, std::size_t chunk_turns): writer_(path), chunkTurns_{std::max<std::size_t>(chunk_turns, 1)} {}
+
+TraceWriter::~TraceWriter()
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+        /// Write errors are reported by an explicit flush(), never by the destructor
+    }
+}
+
+void TraceWriter::operator()(Factory &f, Time t)
+{
+    auto workers = static_cast<std::uint32_t>(std::distance(f.worker_cbegin(), f.worker_cend()));
+    auto storehouses = static_cast<std::uint32_t>(std::distance(f.storehouse_cbegin(), f.storehouse_cend()));
+
+    if (!headerWritten_)
+    {
+        workerCount_ = workers;
+        storehouseCount_ = storehouses;
+
+        writer_.write(trace_magic, sizeof(trace_magic));
+        writer_.write(&workerCount_, sizeof(workerCount_));
+        writer_.write(&storehouseCount_, sizeof(storehouseCount_));
+        std::for_each(f.worker_cbegin(), f.worker_cend(), [this](const Worker& worker)
+        {
+            ElementID id = worker.get_id();
+            writer_.write(&id, sizeof(id));
+        });
+        std::for_each(f.storehouse_cbegin(), f.storehouse_cend(), [this](const Storehouse& storehouse)
+        {
+            ElementID id = storehouse.get_id();
+            writer_.write(&id, sizeof(id));
+        });
+        headerWritten_ = true;
+    }
+    else if (workers != workerCount_ || storehouses != storehouseCount_)
+    {
+        throw std::logic_error("Factory structure changed during tracing");
+    }
+
+    chunk_.times.push_back(t);
+    std::for_each(f.worker_cbegin(), f.worker_cend(), [this](const Worker& worker)
+    {
+        chunk_.queue_lengths.push_back(static_cast<std::uint32_t>(worker.get_queue()->size()));
+        chunk_.processing_buffers.push_back(worker.get_processing_buffer() ? worker.get_processing_buffer()->get_id() : 0);
+        chunk_.sending_buffers.push_back(worker.get_sending_buffer() ? worker.get_sending_buffer()->get_id() : 0);
+    });
+    std::for_each(f.storehouse_cbegin(), f.storehouse_cend(), [this](const Storehouse& storehouse)
+    {
+        chunk_.stock_counts.push_back(storehouse.get_stockpile()->size());
+    });
+
+    if (chunk_.turns() >= chunkTurns_)
+    {
+        flush();
+    }
+}
+
+void TraceWriter::flush()
+{
+    if (chunk_.turns() != 0)
+    {
+        auto turns = static_cast<std::uint32_t>(chunk_.turns());
+        writer_.write(&turns, sizeof(turns));
+        write_column(chunk_.times);
+        write_column(chunk_.queue_lengths);
+        write_column(chunk_.processing_buffers);
+        write_column(chunk_.sending_buffers);
+        write_column(chunk_.stock_counts);
+        chunk_.clear();
+    }
+    writer_.flush();
+}
+
+
+TraceReader::TraceReader(const std::string &path): is_(path, std::ios::binary)
+{
+    char magic[sizeof(trace_magic)];
+    std::uint32_t workers = 0;
+    std::uint32_t storehouses = 0;
+
+    is_.read(magic, sizeof(magic));
+    is_.read(reinterpret_cast<char*>(&workers), sizeof(workers));
+    is_.read(reinterpret_cast<char*>(&storehouses), sizeof(storehouses));
+    if (!is_ || std::memcmp(magic, trace_magic, sizeof(magic)) != 0)
+    {
+        throw std::runtime_error("Not a trace file: " + path);
+    }
+
+    read_column(workerIds_, workers);
+    read_column(storehouseIds_, storehouses);
+}
+
+template<typename T>
+void TraceReader::read_column(std::vector<T> &column, std::size_t size)
+{
+    column.resize(size);
+    is_.read(reinterpret_cast<char*>(column.data()), static_cast<std::streamsize>(size * sizeof(T)));
+    if (!is_)
+    {
+        throw std::runtime_error("Truncated trace file");
+    }
+}
+
+bool TraceReader::read_chunk(TraceChunk &chunk)
+{
+    std::uint32_t turns = 0;
+    if (!is_.read(reinterpret_cast<char*>(&turns), sizeof(turns)))
+    {
+        return false;
+    }
+
+    std::size_t worker_values = static_cast<std::size_t>(turns) * workerIds_.size();
+    read_column(chunk.times, turns);
+    read_column(chunk.queue_lengths, worker_values);
+    read_column(chunk.processing_buffers, worker_values);
+    read_column(chunk.sending_buffers, worker_values);
+    read_column(chunk.stock_counts, static_cast<std::size_t>(turns) * storehouseIds_.size());
+    return true;
+}
@@ -3,10 +3,16 @@
 
 #include "factory.hpp"
 #include "nodes.hpp"
+#include "generator.hpp"
+#include "helpers.hpp"
+#include "reports.hpp"
+#include "simulation.hpp"
 
 // DEBUG
 
 #include <iostream>
+#include <memory_resource>
+#include <sstream>
 
 using ::std::cout;
 using ::std::endl;
@@ -140,4 +146,226 @@ TEST(FactoryTest, RemoveWorkerTwoRemainingReceivers) {
     it = prefs.find(&(*(factory.find_worker_by_id(3))));
     ASSERT_NE(it, prefs.end());
     EXPECT_DOUBLE_EQ(it->second, 1.0 / 2.0);
-}
\ No newline at end of file
+}
+TEST(FactoryTest, SimulatePassesPackagesToStorehouse) {
+    // R -> W -> S
+
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+
+    Ramp& r = *(factory.find_ramp_by_id(1));
+    r.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(1)));
+
+    Worker& w = *(factory.find_worker_by_id(1));
+    w.receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+
+    std::vector<Time> reported_turns;
+    simulate(factory, 3, [&reported_turns](Factory&, Time t) { reported_turns.push_back(t); });
+
+    EXPECT_EQ(reported_turns, (std::vector<Time>{1, 2, 3}));
+
+    auto storehouse_it = factory.storehouse_cbegin();
+    EXPECT_NE(storehouse_it->cbegin(), storehouse_it->cend());
+}
+
+TEST(FactoryTest, SimulateInconsistentFactoryThrows) {
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+
+    EXPECT_THROW(simulate(factory, 1, [](Factory&, Time) {}), std::logic_error);
+}
+
+/// Zlicza alokacje przechodzące przez zasób
+class TrackingResource : public std::pmr::memory_resource {
+public:
+    std::size_t allocations = 0;
+    std::size_t outstanding_bytes = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations;
+        outstanding_bytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        outstanding_bytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+TEST(FactoryTest, QueuesAllocateFromFactoryMemoryResource) {
+    TrackingResource resource;
+    {
+        std::istringstream iss("LOADING_RAMP id=1 delivery-interval=2\n"
+                               "WORKER id=1 processing-time=3 queue-type=FIFO\n"
+                               "STOREHOUSE id=1\n"
+                               "LINK src=ramp-1 dest=worker-1\n"
+                               "LINK src=worker-1 dest=store-1\n");
+        Factory factory = load_factory_structure(iss, &resource);
+        EXPECT_EQ(factory.get_memory_resource(), &resource);
+
+        simulate(factory, 20, [](Factory&, Time) {});
+
+        EXPECT_GT(resource.allocations, 0U);
+        EXPECT_GT(resource.outstanding_bytes, 0U);
+    }
+    EXPECT_EQ(resource.outstanding_bytes, 0U);
+}
+
+TEST(FactoryTest, DrainIntoQueueWithOtherResourceMovesPackages) {
+    TrackingResource resource;
+    PackageQueue source(PackageQueueType::FIFO, &resource);
+    PackageQueue target(PackageQueueType::FIFO);
+    source.push(Package(1));
+    source.push(Package(2));
+
+    EXPECT_EQ(source.drain_into(target), 2U);
+    EXPECT_EQ(target.size(), 2U);
+    EXPECT_EQ(resource.outstanding_bytes, 0U);
+}
+
+TEST(FactoryTest, BatchedPassingMatchesSequential) {
+    FactoryGeneratorParameters params;
+    params.ramps = 10;
+    params.workers = 40;
+    params.storehouses = 4;
+    params.chain_depth = 4;
+    // Jeden odbiorca na nadawcę - kolejność odbiorców w mapie (po adresach) nie wpływa na wynik
+    params.fan_out = 1;
+
+    std::ostringstream structure;
+    {
+        BufferedWriter writer(structure);
+        generate_factory_structure(params, writer);
+    }
+
+    auto run = [&structure](bool batched) {
+        std::istringstream iss(structure.str());
+        Factory factory = load_factory_structure(iss);
+        factory.enable_batched_passing(batched);
+        factory.set_change_tracking(true);
+
+        rng.seed(42);
+        std::ostringstream reports;
+        simulate(factory, 30, [&reports](Factory& f, Time t) {
+            generate_simulation_turn_report(f, reports, t);
+            reports << f.get_changed_receivers().size() << "\n";
+            f.clear_changed_receivers();
+        });
+        // Tyle samo losowań w obu trybach
+        reports << rng();
+        return reports.str();
+    };
+
+    EXPECT_EQ(run(true), run(false));
+}
+
+/// Stan do porównania skip-ahead z krokami co turę (bez ID paczek)
+std::string chain_state(const Factory& factory) {
+    std::ostringstream oss;
+    std::for_each(factory.ramp_cbegin(), factory.ramp_cend(), [&oss](const Ramp& ramp) {
+        oss << "R" << ramp.get_id() << ":" << ramp.get_sending_buffer().has_value() << " ";
+    });
+    std::for_each(factory.worker_cbegin(), factory.worker_cend(), [&oss](const Worker& worker) {
+        oss << "W" << worker.get_id() << ":" << worker.get_queue()->size() << "," << worker.get_processing_buffer().has_value();
+        if (worker.get_processing_buffer()) {oss << "@" << worker.get_package_processing_start_time();}
+        oss << "," << worker.get_sending_buffer().has_value() << " ";
+    });
+    std::for_each(factory.storehouse_cbegin(), factory.storehouse_cend(), [&oss](const Storehouse& storehouse) {
+        oss << "S" << storehouse.get_id() << ":" << storehouse.get_stockpile()->size() << " ";
+    });
+    return oss.str();
+}
+
+TEST(FactoryTest, SkipAheadMatchesSteppingForDeterministicChains) {
+    for (TimeOffset di : {1, 2, 3, 5}) {
+        for (TimeOffset pd : {1, 2, 4, 7}) {
+            // R1 -> W1 -> W2 -> S1 (W2 wolniejszy - kolejka może rosnąć), R2 -> S1
+            std::ostringstream structure;
+            structure << "LOADING_RAMP id=1 delivery-interval=" << di << "\n"
+                      << "LOADING_RAMP id=2 delivery-interval=" << pd << "\n"
+                      << "WORKER id=1 processing-time=" << pd << " queue-type=FIFO\n"
+                      << "WORKER id=2 processing-time=" << pd + 1 << " queue-type=LIFO\n"
+                      << "STOREHOUSE id=1\n"
+                      << "LINK src=ramp-1 dest=worker-1\n"
+                      << "LINK src=ramp-2 dest=store-1\n"
+                      << "LINK src=worker-1 dest=worker-2\n"
+                      << "LINK src=worker-2 dest=store-1\n";
+
+            auto run = [&structure](TimeOffset skip_ahead) {
+                std::istringstream iss(structure.str());
+                Factory factory = load_factory_structure(iss);
+                SimulationOptions options;
+                options.skip_ahead = skip_ahead;
+                std::vector<std::string> states;
+                simulate(factory, 1000, [&states](Factory& f, Time t) {
+                    if (t % 250 == 0) {states.push_back(chain_state(f));}
+                }, options);
+                return states;
+            };
+
+            EXPECT_EQ(run(250), run(0)) << "di=" << di << " pd=" << pd;
+        }
+    }
+}
+
+TEST(FactoryTest, SkipAheadStepsRestOfGraph) {
+    // R1 -> W1 -> S1 to łańcuch; R2 -> {W2, W3} losuje odbiorcę
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=2\n"
+                           "LOADING_RAMP id=2 delivery-interval=3\n"
+                           "WORKER id=1 processing-time=3 queue-type=FIFO\n"
+                           "WORKER id=2 processing-time=1 queue-type=FIFO\n"
+                           "WORKER id=3 processing-time=1 queue-type=FIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "STOREHOUSE id=2\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=ramp-2 dest=worker-2\n"
+                           "LINK src=ramp-2 dest=worker-3\n"
+                           "LINK src=worker-1 dest=store-1\n"
+                           "LINK src=worker-2 dest=store-2\n"
+                           "LINK src=worker-3 dest=store-2\n");
+    Factory factory = load_factory_structure(iss);
+    factory.set_change_tracking(true);
+
+    factory.advance(1, 300);
+
+    // R2 tworzy paczkę w każdej turze niepodzielnej przez 3 (w turze 1 ma jeszcze paczkę z konstruktora),
+    // każda przechodzi przez W2 lub W3 do S2
+    auto in_flight = [&factory](ElementID id) {
+        const Worker& worker = *factory.find_worker_by_id(id);
+        return worker.get_queue()->size() + worker.get_processing_buffer().has_value() + worker.get_sending_buffer().has_value();
+    };
+    std::size_t ramp_buffer = factory.find_ramp_by_id(2)->get_sending_buffer().has_value();
+    EXPECT_EQ(factory.find_storehouse_by_id(2)->get_stockpile()->size() + in_flight(2) + in_flight(3) + ramp_buffer, 200U);
+    EXPECT_GT(factory.find_storehouse_by_id(1)->get_stockpile()->size(), 0U);
+    EXPECT_EQ(factory.get_changed_receivers().count(&*factory.find_storehouse_by_id(1)), 1U);
+}
+
+TEST(FactoryTest, SkipAheadWithConvergenceThrows) {
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=2\n"
+                           "STOREHOUSE id=1\n"
+                           "LINK src=ramp-1 dest=store-1\n");
+    Factory factory = load_factory_structure(iss);
+    SimulationOptions options;
+    options.skip_ahead = 10;
+    options.convergence = ConvergenceParameters();
+
+    EXPECT_THROW(simulate(factory, 100, [](Factory&, Time) {}, options), std::invalid_argument);
+}
+
+TEST(FactoryTest, NegativeSkipAheadThrows) {
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=2\n"
+                           "STOREHOUSE id=1\n"
+                           "LINK src=ramp-1 dest=store-1\n");
+    Factory factory = load_factory_structure(iss);
+    SimulationOptions options;
+    options.skip_ahead = -1;
+
+    EXPECT_THROW(simulate(factory, 100, [](Factory&, Time) {}, options), std::invalid_argument);
+    EXPECT_EQ(factory.find_storehouse_by_id(1)->get_stockpile()->size(), 0U);
+}
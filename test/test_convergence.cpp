@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+
+#include "convergence.hpp"
+#include "factory.hpp"
+#include "simulation.hpp"
+
+#include <sstream>
+
+// R -> W -> S
+Factory make_chain(TimeOffset delivery_interval, TimeOffset processing_time) {
+    std::ostringstream oss;
+    oss << "LOADING_RAMP id=1 delivery-interval=" << delivery_interval << "\n"
+        << "WORKER id=1 processing-time=" << processing_time << " queue-type=FIFO\n"
+        << "STOREHOUSE id=1 stockpile-type=COUNTER\n"
+        << "LINK src=ramp-1 dest=worker-1\n"
+        << "LINK src=worker-1 dest=store-1\n";
+    std::istringstream iss(oss.str());
+    return load_factory_structure(iss);
+}
+
+TEST(ConvergenceTest, StopsAtSteadyState) {
+    Factory factory = make_chain(2, 1);
+
+    SimulationOptions options;
+    options.convergence = ConvergenceParameters{};
+    options.convergence->window = 20;
+
+    SimulationSummary summary = simulate(factory, 100000, [](Factory&, Time) {}, options);
+
+    EXPECT_EQ(summary.stop_reason, StopReason::STEADY_STATE);
+    EXPECT_LT(summary.turns, 1000);
+    EXPECT_EQ(summary.turns % 20, 0);
+}
+
+TEST(ConvergenceTest, DetectsDivergingWorker) {
+    // Robotnik wolniejszy niż rampa - kolejka rośnie bez ograniczeń
+    Factory factory = make_chain(2, 7);
+
+    SimulationOptions options;
+    options.convergence = ConvergenceParameters{};
+    options.convergence->window = 20;
+
+    SimulationSummary summary = simulate(factory, 100000, [](Factory&, Time) {}, options);
+
+    EXPECT_EQ(summary.stop_reason, StopReason::DIVERGED);
+    EXPECT_EQ(summary.diverging_worker, 1U);
+    EXPECT_LT(summary.turns, 1000);
+}
+
+TEST(ConvergenceTest, CountsInflowOfFullRingStockpile) {
+    // Napływ na przemian 10 i 9 paczek na okno - pełny magazyn RING już nie rośnie, ale napływ się zmienia
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=20\n"
+                           "STOREHOUSE id=1 stockpile-type=RING stockpile-capacity=1\n"
+                           "LINK src=ramp-1 dest=store-1\n");
+    Factory factory = load_factory_structure(iss);
+
+    SimulationOptions options;
+    options.convergence = ConvergenceParameters{};
+    options.convergence->window = 10;
+
+    SimulationSummary summary = simulate(factory, 500, [](Factory&, Time) {}, options);
+
+    EXPECT_EQ(summary.stop_reason, StopReason::COMPLETED);
+    EXPECT_EQ(summary.turns, 500);
+    EXPECT_EQ(factory.find_storehouse_by_id(1)->get_received_count(), 500U - 500U / 20);
+}
+
+TEST(ConvergenceTest, RunsAllTurnsWithoutMonitor) {
+    Factory factory = make_chain(2, 7);
+    SimulationSummary summary = simulate(factory, 300, [](Factory&, Time) {});
+
+    EXPECT_EQ(summary.stop_reason, StopReason::COMPLETED);
+    EXPECT_EQ(summary.turns, 300);
+}
+
+TEST(ConvergenceTest, InvalidParametersThrow) {
+    ConvergenceParameters params;
+    params.window = 0;
+    EXPECT_THROW(ConvergenceMonitor{params}, std::invalid_argument);
+}
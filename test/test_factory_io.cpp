@@ -3,6 +3,9 @@
 
 #include "factory.hpp"
 
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <set>
 
 //using ::testing::Return;
@@ -34,6 +37,22 @@ TEST(FactoryIOTest, ParseWorker) {
     EXPECT_EQ(PackageQueueType::FIFO, w.get_queue()->get_queue_type());
 }
 
+TEST(FactoryIOTest, ParseWorkerCapacity) {
+    std::istringstream iss("WORKER id=1 processing-time=2 queue-type=FIFO capacity=5 backpressure=REROUTE\n"
+                           "WORKER id=2 processing-time=2 queue-type=FIFO\n");
+    auto factory = load_factory_structure(iss);
+
+    const auto& w1 = *(factory.find_worker_by_id(1));
+    EXPECT_EQ(w1.get_capacity(), 5U);
+    EXPECT_EQ(w1.get_backpressure_policy(), BackpressurePolicy::REROUTE);
+    EXPECT_EQ(factory.find_worker_by_id(2)->get_capacity(), 0U);
+
+    std::ostringstream oss;
+    save_factory_structure(factory, oss);
+    EXPECT_NE(oss.str().find("WORKER id=1 processing-time=2 queue-type=FIFO capacity=5 backpressure=REROUTE\n"), std::string::npos);
+    EXPECT_NE(oss.str().find("WORKER id=2 processing-time=2 queue-type=FIFO\n"), std::string::npos);
+}
+
 TEST(FactoryIOTest, ParseStorehouse) {
     std::istringstream iss("STOREHOUSE id=1");
     auto factory = load_factory_structure(iss);
@@ -43,6 +62,24 @@ TEST(FactoryIOTest, ParseStorehouse) {
     EXPECT_EQ(1, s.get_id());
 }
 
+TEST(FactoryIOTest, ParseStorehouseStockpileType) {
+    std::istringstream iss("STOREHOUSE id=1 stockpile-type=COUNTER\n"
+                           "STOREHOUSE id=2 stockpile-type=RING stockpile-capacity=10\n"
+                           "STOREHOUSE id=3\n");
+    auto factory = load_factory_structure(iss);
+
+    EXPECT_NE(dynamic_cast<const CountingStockpile*>(factory.find_storehouse_by_id(1)->get_stockpile()), nullptr);
+    auto ring = dynamic_cast<const RingStockpile*>(factory.find_storehouse_by_id(2)->get_stockpile());
+    ASSERT_NE(ring, nullptr);
+    EXPECT_EQ(ring->get_capacity(), 10U);
+
+    std::ostringstream oss;
+    save_factory_structure(factory, oss);
+    EXPECT_NE(oss.str().find("STOREHOUSE id=1 stockpile-type=COUNTER\n"), std::string::npos);
+    EXPECT_NE(oss.str().find("STOREHOUSE id=2 stockpile-type=RING stockpile-capacity=10\n"), std::string::npos);
+    EXPECT_NE(oss.str().find("STOREHOUSE id=3\n"), std::string::npos);
+}
+
 TEST(FactoryIOTest, ParseLinkOneReceiver) {
     std::ostringstream oss;
     oss << "LOADING_RAMP id=1 delivery-interval=3" << "\n"
@@ -243,3 +280,160 @@ TEST(FactoryIOTest, LoadAndSaveTest) {
     ASSERT_LT(first_worker_it, first_storehouse_it);
     ASSERT_LT(first_storehouse_it, first_link_it);
 }
+
+TEST(FactoryIOTest, SaveToFileMatchesStream) {
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=3\n"
+                           "WORKER id=1 processing-time=2 queue-type=LIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=worker-1 dest=store-1\n");
+    auto factory = load_factory_structure(iss);
+
+    std::ostringstream oss;
+    save_factory_structure(factory, oss);
+
+    std::string path = (std::filesystem::temp_directory_path() / "SymulacjaSieci_save_test.txt").string();
+    save_factory_structure(static_cast<const Factory&>(factory), path);
+
+    std::ifstream ifs(path);
+    std::string saved((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(saved, oss.str());
+}
+
+TEST(FactoryIOTest, BufferedWriterFlushesLargeOutput) {
+    std::ostringstream oss;
+    {
+        BufferedWriter writer(oss, 64);
+        for (int i = 0; i < 100; ++i) {
+            writer << "id=" << i << '\n';
+        }
+    }
+
+    std::ostringstream expected;
+    for (int i = 0; i < 100; ++i) {
+        expected << "id=" << i << '\n';
+    }
+    EXPECT_EQ(oss.str(), expected.str());
+}
+
+TEST(FactoryIOTest, ApplyPatch) {
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=3\n"
+                           "WORKER id=1 processing-time=2 queue-type=FIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=worker-1 dest=store-1\n");
+    auto factory = load_factory_structure(iss);
+
+    std::istringstream patch("; reroute ramp-1 through a new worker\n"
+                             "ADD WORKER id=2 processing-time=1 queue-type=LIFO\n"
+                             "ADD STOREHOUSE id=2\n"
+                             "LINK src=worker-2 dest=store-2\n"
+                             "UNLINK src=ramp-1 dest=worker-1\n"
+                             "LINK src=ramp-1 dest=worker-2\n"
+                             "REMOVE STOREHOUSE id=1\n");
+    apply_factory_patch(factory, patch);
+
+    const auto& r = *(factory.find_ramp_by_id(1));
+    const auto& w1 = *(factory.find_worker_by_id(1));
+    auto& w2 = *(factory.find_worker_by_id(2));
+
+    ASSERT_EQ(factory.find_storehouse_by_id(1), factory.storehouse_cend());
+    EXPECT_EQ(PackageQueueType::LIFO, w2.get_queue()->get_queue_type());
+
+    ASSERT_EQ(1U, r.receiver_preferences_.get_preferences().size());
+    EXPECT_EQ(&w2, r.receiver_preferences_.begin()->first);
+    EXPECT_TRUE(w1.receiver_preferences_.get_preferences().empty());
+    EXPECT_TRUE(factory.is_consistent());
+}
+
+TEST(FactoryIOTest, ApplyPatchDuplicateNode) {
+    std::istringstream iss("WORKER id=1 processing-time=2 queue-type=FIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "LINK src=worker-1 dest=store-1\n");
+    auto factory = load_factory_structure(iss);
+
+    std::istringstream patch("ADD WORKER id=1 processing-time=1 queue-type=LIFO\n");
+    EXPECT_THROW(apply_factory_patch(factory, patch), std::invalid_argument);
+
+    // Pierwszy pracownik pozostaje osiągalny i jest jedynym o tym ID
+    ASSERT_NE(factory.find_worker_by_id(1), factory.worker_end());
+    EXPECT_EQ(2, factory.find_worker_by_id(1)->get_processing_duration());
+    EXPECT_EQ(1, std::distance(factory.worker_cbegin(), factory.worker_cend()));
+
+    factory.remove_worker(1);
+    EXPECT_EQ(factory.worker_cbegin(), factory.worker_cend());
+}
+
+TEST(FactoryIOTest, ApplyPatchUnknownNode) {
+    Factory factory;
+    std::istringstream patch("LINK src=ramp-1 dest=store-1\n");
+
+    EXPECT_THROW(apply_factory_patch(factory, patch), std::runtime_error);
+}
+
+TEST(FactoryIOTest, ApplyPatchIsAllOrNothing) {
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=3\n"
+                           "WORKER id=1 processing-time=2 queue-type=FIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=worker-1 dest=store-1\n");
+    auto factory = load_factory_structure(iss);
+    std::ostringstream before;
+    save_factory_structure(factory, before);
+
+    // Błąd w dalszej linii - wcześniejsze kroki nie są wykonywane
+    for (const char* bad_line : {"LINK src=worker-2 dest=store-3\n", "ADD STOREHOUSE id=2\n",
+                                 "LINK src=ramp-1 dest=worker-1 FOO\nMOVE WORKER id=1\n",
+                                 "ADD STOREHOUSE id=4 stockpile-type=BAG\n"}) {
+        std::istringstream patch(std::string("ADD WORKER id=2 processing-time=1 queue-type=LIFO\n"
+                                             "ADD STOREHOUSE id=2\n"
+                                             "LINK src=worker-2 dest=store-2\n"
+                                             "REMOVE STOREHOUSE id=1\n") + bad_line);
+        EXPECT_ANY_THROW(apply_factory_patch(factory, patch));
+
+        std::ostringstream after;
+        save_factory_structure(factory, after);
+        EXPECT_EQ(before.str(), after.str());
+    }
+
+    // Węzeł usunięty wcześniej w łatce nie może być połączony
+    std::istringstream patch("REMOVE WORKER id=1\nLINK src=ramp-1 dest=worker-1\n");
+    EXPECT_THROW(apply_factory_patch(factory, patch), std::runtime_error);
+    EXPECT_NE(factory.find_worker_by_id(1), factory.worker_end());
+}
+
+TEST(FactoryIOTest, ApplyPatchRemoveUnlinksSenders) {
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=3\n"
+                           "LOADING_RAMP id=2 delivery-interval=3\n"
+                           "WORKER id=1 processing-time=2 queue-type=FIFO\n"
+                           "WORKER id=2 processing-time=2 queue-type=FIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "STOREHOUSE id=2\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=ramp-2 dest=worker-1\n"
+                           "LINK src=ramp-2 dest=worker-2\n"
+                           "LINK src=worker-1 dest=worker-1\n"
+                           "LINK src=worker-1 dest=store-1\n"
+                           "LINK src=worker-2 dest=store-1\n");
+    auto factory = load_factory_structure(iss);
+
+    // Połączenia dodane i usunięte w łatce po pierwszym REMOVE też są uwzględniane
+    std::istringstream patch("REMOVE WORKER id=1\n"
+                             "LINK src=ramp-1 dest=worker-2\n"
+                             "LINK src=worker-2 dest=store-2\n"
+                             "UNLINK src=worker-2 dest=store-1\n"
+                             "LINK src=worker-2 dest=store-1\n"
+                             "REMOVE STOREHOUSE id=1\n"
+                             "REMOVE WORKER id=2\n"
+                             "REMOVE LOADING_RAMP id=7\n");
+    apply_factory_patch(factory, patch);
+
+    EXPECT_EQ(factory.worker_cbegin(), factory.worker_cend());
+    for (auto it = factory.ramp_cbegin(); it != factory.ramp_cend(); ++it) {
+        EXPECT_TRUE(it->receiver_preferences_.get_preferences().empty());
+    }
+    EXPECT_EQ(factory.find_storehouse_by_id(1), factory.storehouse_cend());
+    EXPECT_NE(factory.find_storehouse_by_id(2), factory.storehouse_cend());
+}
@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "flow.hpp"
+#include "simulation.hpp"
+
+#include <sstream>
+
+Factory load(const std::string& structure) {
+    std::istringstream iss(structure);
+    return load_factory_structure(iss);
+}
+
+TEST(FlowEstimateTest, SplitsFlowByPreferences) {
+    // R(1/2) -> W1 (1/1) -> {W2 (1/4), S1}, W2 -> S2
+    Factory factory = load("LOADING_RAMP id=1 delivery-interval=2\n"
+                           "WORKER id=1 processing-time=1 queue-type=FIFO\n"
+                           "WORKER id=2 processing-time=4 queue-type=FIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "STOREHOUSE id=2\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=worker-1 dest=worker-2\n"
+                           "LINK src=worker-1 dest=store-1\n"
+                           "LINK src=worker-2 dest=store-2\n");
+
+    FlowEstimate estimate = estimate_flow(factory);
+
+    ASSERT_TRUE(estimate.converged);
+    ASSERT_EQ(estimate.workers.size(), 2U);
+    EXPECT_DOUBLE_EQ(estimate.input_rate, 0.5);
+    EXPECT_DOUBLE_EQ(estimate.workers[0].arrival_rate, 0.5);
+    EXPECT_DOUBLE_EQ(estimate.workers[0].utilization, 0.5);
+    EXPECT_FALSE(estimate.workers[0].bottleneck);
+
+    // Połowa do W2: 0.25 przy wydajności 0.25 - na granicy
+    EXPECT_DOUBLE_EQ(estimate.workers[1].arrival_rate, 0.25);
+    EXPECT_TRUE(estimate.workers[1].bottleneck);
+    EXPECT_DOUBLE_EQ(estimate.output_rate, 0.5);
+}
+
+TEST(FlowEstimateTest, SaturatedWorkerCapsDownstreamFlow) {
+    Factory factory = load("LOADING_RAMP id=1 delivery-interval=1\n"
+                           "LOADING_RAMP id=2 delivery-interval=1\n"
+                           "WORKER id=1 processing-time=4 queue-type=FIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=ramp-2 dest=worker-1\n"
+                           "LINK src=worker-1 dest=store-1\n");
+
+    FlowEstimate estimate = estimate_flow(factory);
+
+    EXPECT_DOUBLE_EQ(estimate.workers[0].utilization, 8.0);
+    EXPECT_TRUE(estimate.workers[0].bottleneck);
+    EXPECT_DOUBLE_EQ(estimate.storehouses[0].arrival_rate, 0.25);
+
+    std::ostringstream oss;
+    generate_flow_report(estimate, oss);
+    EXPECT_NE(oss.str().find("WORKER #1 (BOTTLENECK)"), std::string::npos);
+}
+
+TEST(FlowEstimateTest, CycleConverges) {
+    // W1 -> {W2, S}, W2 -> W1: przepływ przez W1 to 2 * wejście
+    Factory factory = load("LOADING_RAMP id=1 delivery-interval=10\n"
+                           "WORKER id=1 processing-time=1 queue-type=FIFO\n"
+                           "WORKER id=2 processing-time=1 queue-type=FIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=worker-1 dest=worker-2\n"
+                           "LINK src=worker-1 dest=store-1\n"
+                           "LINK src=worker-2 dest=worker-1\n");
+
+    FlowEstimate estimate = estimate_flow(factory);
+
+    ASSERT_TRUE(estimate.converged);
+    EXPECT_NEAR(estimate.workers[0].arrival_rate, 0.2, 1e-9);
+    EXPECT_NEAR(estimate.workers[1].arrival_rate, 0.1, 1e-9);
+    EXPECT_NEAR(estimate.output_rate, 0.1, 1e-9);
+}
+
+TEST(FlowEstimateTest, SimulatedRampRateMatchesSimulation) {
+    Factory factory = load("LOADING_RAMP id=1 delivery-interval=3\n"
+                           "WORKER id=1 processing-time=1 queue-type=FIFO\n"
+                           "STOREHOUSE id=1 stockpile-type=COUNTER\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=worker-1 dest=store-1\n");
+
+    FlowParameters params;
+    params.ramp_rate = RampRateModel::SIMULATED;
+    FlowEstimate estimate = estimate_flow(factory, params);
+
+    constexpr TimeOffset turns = 3000;
+    simulate(factory, turns, [](Factory&, Time) {});
+    double simulated = static_cast<double>(factory.find_storehouse_by_id(1)->get_stockpile()->size()) / turns;
+
+    EXPECT_NEAR(estimate.output_rate, simulated, 0.01);
+}
+
+TEST(FlowEstimateTest, InconsistentFactoryThrows) {
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    EXPECT_THROW(estimate_flow(factory), std::logic_error);
+}
@@ -0,0 +1,66 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "generator.hpp"
+
+#include <iterator>
+#include <sstream>
+
+std::string generate_structure(const FactoryGeneratorParameters& params) {
+    std::ostringstream oss;
+    BufferedWriter writer(oss);
+    generate_factory_structure(params, writer);
+    return oss.str();
+}
+
+TEST(GeneratorTest, GeneratedFactoryIsConsistent) {
+    FactoryGeneratorParameters params;
+    params.ramps = 5;
+    params.workers = 40;
+    params.storehouses = 3;
+    params.fan_out = 3;
+    params.chain_depth = 4;
+    params.cycles = 10;
+    params.seed = 7;
+
+    std::istringstream iss(generate_structure(params));
+    Factory factory = load_factory_structure(iss);
+
+    EXPECT_EQ(std::distance(factory.ramp_cbegin(), factory.ramp_cend()), 5);
+    EXPECT_EQ(std::distance(factory.worker_cbegin(), factory.worker_cend()), 40);
+    EXPECT_EQ(std::distance(factory.storehouse_cbegin(), factory.storehouse_cend()), 3);
+    EXPECT_TRUE(factory.is_consistent());
+}
+
+TEST(GeneratorTest, RampsOnly) {
+    FactoryGeneratorParameters params;
+    params.ramps = 3;
+    params.workers = 0;
+    params.storehouses = 2;
+
+    std::istringstream iss(generate_structure(params));
+    Factory factory = load_factory_structure(iss);
+
+    EXPECT_TRUE(factory.is_consistent());
+}
+
+TEST(GeneratorTest, SameSeedSameOutput) {
+    FactoryGeneratorParameters params;
+    params.workers = 20;
+    params.chain_depth = 3;
+    params.cycles = 2;
+
+    std::string first = generate_structure(params);
+    EXPECT_EQ(first, generate_structure(params));
+
+    params.seed = 2;
+    EXPECT_NE(first, generate_structure(params));
+}
+
+TEST(GeneratorTest, NoStorehouseRejected) {
+    FactoryGeneratorParameters params;
+    params.storehouses = 0;
+
+    EXPECT_THROW(generate_structure(params), std::invalid_argument);
+}
@@ -0,0 +1,92 @@
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "instrumentation.hpp"
+#include "simulation.hpp"
+
+#include <sstream>
+
+TEST(InstrumentationTest, RecordsPhasesOnlyWhileEnabled) {
+    InstrumentationRecorder recorder;
+    auto start = InstrumentationRecorder::clock::now();
+    recorder.record_phase("ignored", start, start);
+
+    recorder.enable(true);
+    recorder.record_phase("do_work", start, start + std::chrono::microseconds(3));
+    recorder.record_phase("do_work", start, start + std::chrono::microseconds(2));
+    recorder.add(InstrumentationCounter::PACKAGES_MOVED, 4);
+    recorder.enable(false);
+    recorder.add(InstrumentationCounter::PACKAGES_MOVED, 1);
+
+    auto totals = recorder.get_phase_totals();
+    ASSERT_EQ(totals.count("do_work"), 1U);
+    EXPECT_EQ(totals["do_work"].calls, 2U);
+    EXPECT_EQ(totals["do_work"].nanoseconds, 5000U);
+    EXPECT_EQ(recorder.get_counter(InstrumentationCounter::PACKAGES_MOVED), 4U);
+
+    // Ponowne włączenie czyści zapis
+    recorder.enable(true);
+    EXPECT_TRUE(recorder.get_phase_totals().empty());
+    EXPECT_EQ(recorder.get_counter(InstrumentationCounter::PACKAGES_MOVED), 0U);
+}
+
+TEST(InstrumentationTest, WritesChromeTraceEvents) {
+    InstrumentationRecorder recorder;
+    recorder.enable(true);
+    auto start = InstrumentationRecorder::clock::now();
+    recorder.record_phase("do_deliveries", start, start + std::chrono::nanoseconds(1500));
+    recorder.add(InstrumentationCounter::RNG_DRAWS, 7);
+    recorder.sample_counters();
+
+    std::ostringstream oss;
+    recorder.write_chrome_trace(oss);
+    std::string trace = oss.str();
+
+    EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0U);
+    EXPECT_NE(trace.find("\"name\":\"do_deliveries\",\"cat\":\"phase\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(trace.find("\"dur\":1.500}"), std::string::npos);
+    EXPECT_NE(trace.find("\"ph\":\"C\""), std::string::npos);
+    EXPECT_NE(trace.find("\"rng_draws\":7"), std::string::npos);
+    EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+}
+
+TEST(InstrumentationTest, EventLimitKeepsTotals) {
+    InstrumentationRecorder recorder;
+    recorder.enable(true, 2);
+    auto start = InstrumentationRecorder::clock::now();
+    for (int i = 0; i < 5; ++i) {
+        recorder.record_phase("report", start, start);
+    }
+
+    EXPECT_EQ(recorder.get_phase_totals()["report"].calls, 5U);
+    EXPECT_EQ(recorder.get_dropped_events(), 3U);
+}
+
+TEST(InstrumentationTest, SimulationHooks) {
+    if (!instrumentation_compiled_in) {
+        GTEST_SKIP() << "Built without SYMULACJASIECI_INSTRUMENTATION";
+    }
+
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=2\n"
+                           "WORKER id=1 processing-time=1 queue-type=FIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=worker-1 dest=store-1\n");
+    Factory factory = load_factory_structure(iss);
+
+    instrumentation().enable(true);
+    simulate(factory, 10, [](Factory&, Time) {});
+    instrumentation().enable(false);
+
+    auto totals = instrumentation().get_phase_totals();
+    EXPECT_EQ(totals["do_deliveries"].calls, 10U);
+    EXPECT_EQ(totals["do_package_passing"].calls, 10U);
+    EXPECT_EQ(totals["do_work"].calls, 10U);
+    EXPECT_EQ(totals["report"].calls, 10U);
+    EXPECT_EQ(totals["is_consistent"].calls, 1U);
+    EXPECT_GT(instrumentation().get_counter(InstrumentationCounter::PACKAGES_MOVED), 0U);
+    EXPECT_EQ(instrumentation().get_counter(InstrumentationCounter::QUEUE_PUSHES),
+              instrumentation().get_counter(InstrumentationCounter::PACKAGES_MOVED));
+    EXPECT_EQ(instrumentation().get_counter(InstrumentationCounter::RNG_DRAWS),
+              instrumentation().get_counter(InstrumentationCounter::PACKAGES_MOVED));
+}
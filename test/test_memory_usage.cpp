@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "memory_usage.hpp"
+#include "simulation.hpp"
+
+#include <sstream>
+
+TEST(MemoryUsageTest, CountingResourceTracksBytes) {
+    CountingMemoryResource resource;
+    void* a = resource.allocate(64);
+    void* b = resource.allocate(32);
+    resource.deallocate(a, 64);
+
+    EXPECT_EQ(resource.get_bytes_in_use(), 32U);
+    EXPECT_EQ(resource.get_peak_bytes(), 96U);
+    EXPECT_EQ(resource.get_allocations(), 2U);
+    resource.deallocate(b, 32);
+}
+
+TEST(MemoryUsageTest, QueueEstimateMatchesAllocations) {
+    CountingMemoryResource resource;
+    PackageQueue queue(PackageQueueType::LIFO, &resource);
+    for (int i = 0; i < 10; ++i) {
+        queue.push(Package());
+    }
+    queue.pop();
+
+    EXPECT_EQ(queue.get_memory_usage(), resource.get_bytes_in_use());
+    EXPECT_EQ(CountingStockpile().get_memory_usage(), 0U);
+}
+
+TEST(MemoryUsageTest, FactoryQueuesAndStockpilesMatchResource) {
+    CountingMemoryResource resource;
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=2\n"
+                           "WORKER id=1 processing-time=3 queue-type=FIFO\n"
+                           "WORKER id=2 processing-time=1 queue-type=LIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "STOREHOUSE id=2 stockpile-type=RING stockpile-capacity=4\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=worker-1 dest=worker-2\n"
+                           "LINK src=worker-1 dest=store-1\n"
+                           "LINK src=worker-2 dest=store-1\n"
+                           "LINK src=worker-2 dest=store-2\n");
+    Factory factory = load_factory_structure(iss, &resource);
+    simulate(factory, 100, [](Factory&, Time) {});
+
+    MemoryUsage usage = collect_memory_usage(factory);
+
+    EXPECT_EQ(usage.queues + usage.stockpiles, resource.get_bytes_in_use());
+    ASSERT_EQ(usage.workers.size(), 2U);
+    EXPECT_GT(usage.workers[0].packages, 0U);
+    EXPECT_GT(usage.storehouses[0].packages, 0U);
+    // Magazyn pierścieniowy trzyma najwyżej 4 paczki
+    EXPECT_EQ(usage.storehouses[1].packages, 4 * list_node_bytes<Package>);
+    EXPECT_GT(usage.preferences, 0U);
+    EXPECT_GT(usage.node_collections, 0U);
+    EXPECT_GT(usage.package_ids, 0U);
+    EXPECT_EQ(usage.total(), usage.node_collections + usage.queues + usage.stockpiles + usage.preferences + usage.package_ids);
+}
+
+TEST(MemoryUsageTest, ReportListsLargestNodesFirst) {
+    MemoryUsage usage;
+    usage.ramps.push_back({1, 0, 64});
+    usage.workers.push_back({1, 320, 64});
+    usage.storehouses.push_back({1, 96, 0});
+    usage.queues = 320;
+
+    std::ostringstream oss;
+    generate_memory_report(usage, oss, 2);
+    std::string report = oss.str();
+
+    EXPECT_NE(report.find("Worker queues: 320"), std::string::npos);
+    EXPECT_LT(report.find("WORKER #1: 384 bytes"), report.find("STOREHOUSE #1: 96 bytes"));
+    EXPECT_EQ(report.find("LOADING RAMP #1"), std::string::npos);
+}
@@ -10,6 +10,7 @@
 #include "global_functions_mock.hpp"
 
 #include <iostream>
+#include <map>
 
 using ::std::cout;
 using ::std::endl;
@@ -115,6 +116,23 @@ TEST_F(ReceiverPreferencesChoosingTest, ChooseReceiver) {
     }
 }
 
+TEST(ReceiverPreferencesTest, ChooseReceiverForDrawMatchesGenerator) {
+    double u = 0;
+    ReceiverPreferences rp([&u]() { return u; });
+
+    MockReceiver r1, r2, r3;
+    rp.add_receiver(&r1);
+    rp.add_receiver(&r2);
+    rp.add_receiver(&r3);
+    EXPECT_FALSE(rp.has_default_generator());
+    EXPECT_TRUE(ReceiverPreferences(default_probability_generator).has_default_generator());
+
+    for (int i = 0; i < 100; ++i) {
+        u = i / 100.0;
+        EXPECT_EQ(rp.choose_receiver(u), rp.choose_receiver()) << "u = " << u;
+    }
+}
+
 // -----------------
 
 using ::testing::Return;
@@ -158,4 +176,133 @@ TEST(PackageSenderTest, SendPackage) {
 
     // Upewnij się, że proces wysyłania zachodzi tylko wówczas, gdy w bufor jest pełny.
     sender.send_package();
-}
\ No newline at end of file
+}
+TEST(PackageSenderTest, BoundedWorkerKeepsPackageInSenderOnRetry) {
+    Worker w(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO), 1, BackpressurePolicy::RETRY);
+
+    PackageSenderFixture sender;
+    sender.receiver_preferences_.add_receiver(&w);
+
+    sender.push_package(Package(1));
+    EXPECT_EQ(sender.send_package(), &w);
+
+    // Kolejka robotnika pełna - paczka zostaje w buforze nadawcy
+    sender.push_package(Package(2));
+    EXPECT_EQ(sender.send_package(), nullptr);
+    ASSERT_TRUE(sender.get_sending_buffer().has_value());
+    EXPECT_EQ(w.get_queue()->size(), 1U);
+
+    w.do_work(1);
+    EXPECT_EQ(sender.send_package(), &w);
+    EXPECT_FALSE(sender.get_sending_buffer().has_value());
+}
+
+TEST(PackageSenderTest, BoundedWorkerReroutesToFreeReceiver) {
+    Worker w1(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO), 1, BackpressurePolicy::REROUTE);
+    Worker w2(2, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO), 1, BackpressurePolicy::REROUTE);
+
+    PackageSenderFixture sender;
+    sender.receiver_preferences_.add_receiver(&w1);
+    sender.receiver_preferences_.add_receiver(&w2);
+
+    sender.push_package(Package(1));
+    sender.send_package();
+    sender.push_package(Package(2));
+    sender.send_package();
+
+    // Niezależnie od losowania każdy robotnik dostał jedną paczkę
+    EXPECT_EQ(w1.get_queue()->size(), 1U);
+    EXPECT_EQ(w2.get_queue()->size(), 1U);
+
+    // Obie kolejki pełne - paczka czeka u nadawcy
+    sender.push_package(Package(3));
+    EXPECT_EQ(sender.send_package(), nullptr);
+    EXPECT_TRUE(sender.get_sending_buffer().has_value());
+}
+
+TEST(WorkerTest, FinishedPackageWaitsForSendingBuffer) {
+    Worker w(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO));
+
+    w.receive_package(Package(1));
+    w.receive_package(Package(2));
+    w.do_work(1);
+    w.do_work(2);
+
+    ASSERT_TRUE(w.get_sending_buffer().has_value());
+    EXPECT_EQ(w.get_sending_buffer()->get_id(), 1);
+    ASSERT_TRUE(w.get_processing_buffer().has_value());
+    EXPECT_EQ(w.get_processing_buffer()->get_id(), 2);
+}
+
+/// Krokuje Worker i StaticWorker obok siebie; paczki przyjęte w tej samej turze tworzą parę ID
+template <PackageQueueType QueueType>
+void step_side_by_side() {
+    Worker w(1, 2, std::make_unique<PackageQueue>(QueueType), 2);
+    StaticWorker<QueueType> sw(2, 2, 2);
+    StatisticsCollector collector;
+    w.attach_statistics(&collector);
+    sw.attach_statistics(&collector);
+    Storehouse s(1);
+    std::map<ElementID, ElementID> pairs;
+    auto paired = [&pairs](const Package& p, const Package& sp) {
+        return pairs.at(p.get_id()) == sp.get_id();
+    };
+
+    for (Time t = 1; t <= 12; ++t) {
+        collector.start_turn(t);
+        if (t <= 5) {
+            ASSERT_EQ(w.can_receive_package(), sw.can_receive_package());
+            if (w.can_receive_package()) {
+                Package p;
+                Package sp;
+                pairs[p.get_id()] = sp.get_id();
+                w.receive_package(std::move(p));
+                sw.receive_package(std::move(sp));
+            }
+        }
+        if (t % 3 == 0) {
+            // Wysyłki do magazynu co trzecią turę
+            w.receiver_preferences_.add_receiver(&s);
+            sw.receiver_preferences_.add_receiver(&s);
+            w.send_package();
+            sw.send_package();
+            w.receiver_preferences_.remove_receiver(&s);
+            sw.receiver_preferences_.remove_receiver(&s);
+        }
+        w.do_work(t);
+        sw.do_work(t);
+
+        ASSERT_EQ(w.get_processing_buffer().has_value(), sw.get_processing_buffer().has_value());
+        if (w.get_processing_buffer()) {
+            EXPECT_TRUE(paired(*w.get_processing_buffer(), *sw.get_processing_buffer()));
+        }
+        ASSERT_EQ(w.get_sending_buffer().has_value(), sw.get_sending_buffer().has_value());
+        if (w.get_sending_buffer()) {
+            EXPECT_TRUE(paired(*w.get_sending_buffer(), *sw.get_sending_buffer()));
+        }
+        ASSERT_EQ(w.get_queue()->size(), sw.get_queue().size());
+        for (auto it = w.cbegin(), sit = sw.cbegin(); it != w.cend(); ++it, ++sit) {
+            EXPECT_TRUE(paired(*it, *sit));
+        }
+        EXPECT_EQ(w.get_package_processing_start_time(), sw.get_package_processing_start_time());
+    }
+
+    const WorkerStatistics& ws = w.get_statistics();
+    const WorkerStatistics& sws = sw.get_statistics();
+    EXPECT_EQ(ws.busy_turns, sws.busy_turns);
+    EXPECT_EQ(ws.idle_turns, sws.idle_turns);
+    EXPECT_EQ(ws.queue_length_sum, sws.queue_length_sum);
+    EXPECT_EQ(ws.queue_length_max, sws.queue_length_max);
+    EXPECT_EQ(ws.full_turns, sws.full_turns);
+    EXPECT_EQ(ws.queue_wait.count(), sws.queue_wait.count());
+    EXPECT_EQ(ws.queue_wait.max(), sws.queue_wait.max());
+    EXPECT_GT(ws.full_turns, 0U);
+}
+
+TEST(StaticWorkerTest, StepsLikeWorkerFifo) {
+    step_side_by_side<PackageQueueType::FIFO>();
+}
+
+TEST(StaticWorkerTest, StepsLikeWorkerLifo) {
+    step_side_by_side<PackageQueueType::LIFO>();
+}
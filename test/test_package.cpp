@@ -38,3 +38,17 @@ TEST(PackageTest, IsAssignmentOperatorCorrect) {
 
     EXPECT_EQ(p2.get_id(), 1);
 }
+
+TEST(PackageTest, IsAssignmentToMovedFromCorrect) {
+    // przypisanie do przeniesionej paczki nie zwalnia ID 0
+
+    Package p1;
+    Package p2;
+    Package p3(std::move(p1));
+    p1 = std::move(p2);
+    Package p4;
+
+    EXPECT_EQ(p1.get_id(), 2);
+    EXPECT_EQ(p3.get_id(), 1);
+    EXPECT_EQ(p4.get_id(), 3);
+}
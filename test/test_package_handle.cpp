@@ -0,0 +1,224 @@
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "package_handle.hpp"
+#include "simulation.hpp"
+
+#include <set>
+#include <sstream>
+#include <vector>
+
+// ID są wspólne dla całego procesu - testy porównują je z ID pobranymi przez siebie, nie z 1, 2, 3...
+
+TEST(PackageLedgerTest, MintsLowestFreeId) {
+    PackageLedger ledger;
+    PackageHandle p1 = ledger.mint();
+    PackageHandle p2 = ledger.mint();
+    PackageHandle p3 = ledger.mint(7);
+
+    EXPECT_LT(p1.id, p2.id);
+    EXPECT_LT(p2.id, p3.id);
+    EXPECT_EQ(p3.creation_time, 7);
+    EXPECT_EQ(ledger.live_count(), 3U);
+
+    ledger.retire(p3);
+    ledger.retire(p1);
+    EXPECT_FALSE(ledger.is_live(p1.id));
+    PackageHandle p4 = ledger.mint();
+    PackageHandle p5 = ledger.mint();
+    PackageHandle p6 = ledger.mint();
+    EXPECT_EQ(p4.id, p1.id);
+    EXPECT_EQ(p5.id, p3.id);
+    EXPECT_GT(p6.id, p3.id);
+
+    // Kopia uchwytu nie zmienia stanu rejestru
+    PackageHandle copy = p2;
+    ledger.retire(copy);
+    EXPECT_THROW(ledger.retire(p2), std::logic_error);
+
+    for (const PackageHandle& handle : {p4, p5, p6}) {
+        ledger.retire(handle);
+    }
+    EXPECT_EQ(ledger.live_count(), 0U);
+}
+
+TEST(PackageLedgerTest, SharesIdsWithPackages) {
+    // Uchwyty i paczki korzystają z jednej puli ID - brak kolizji
+    PackageLedger ledger;
+    Package p1;
+    PackageHandle h = ledger.mint();
+    Package p2;
+    EXPECT_LT(p1.get_id(), h.id);
+    EXPECT_LT(h.id, p2.get_id());
+
+    {
+        // Paczka przejmuje ID uchwytu i zwalnia je przy zniszczeniu
+        Package adopted(h);
+        EXPECT_EQ(adopted.get_id(), h.id);
+        ledger.retire(adopted);
+        EXPECT_FALSE(ledger.is_live(h.id));
+        EXPECT_THROW(ledger.retire(adopted), std::logic_error);
+    }
+    EXPECT_EQ(Package().get_id(), h.id);
+
+    ElementID p2_id = p2.get_id();
+    PackageHandle released = p2.release();
+    EXPECT_EQ(p2.get_id(), 0U);
+    EXPECT_EQ(released.id, p2_id);
+    EXPECT_EQ(Package().get_id(), h.id);
+    Package readopted(released);
+    EXPECT_EQ(readopted.get_id(), p2_id);
+
+    // Paczka utworzona bez rejestru może zostać do niego przyjęta
+    ledger.adopt(p1);
+    ledger.adopt(p1);
+    EXPECT_TRUE(ledger.is_live(p1.get_id()));
+    EXPECT_EQ(ledger.live_count(), 1U);
+    ledger.retire(p1);
+    EXPECT_EQ(ledger.live_count(), 0U);
+}
+
+TEST(HandleStockpileTest, HoldsIdsUntilDestroyed) {
+    ElementID first_id = 0;
+    {
+        HandleStockpile stockpile;
+        Package first;
+        first_id = first.get_id();
+        stockpile.push(std::move(first));
+        std::vector<Package> packages(3);
+        stockpile.push_bulk(std::move(packages));
+        stockpile.push_new(2);
+
+        ASSERT_EQ(stockpile.size(), 6U);
+        EXPECT_TRUE(packages.empty());
+        EXPECT_EQ(stockpile.begin(), stockpile.end());
+        std::set<ElementID> ids;
+        for (std::size_t i = 0; i < stockpile.size(); ++i) {
+            ids.insert(stockpile.get_handles()[i].id);
+        }
+        EXPECT_EQ(ids.size(), 6U);
+        EXPECT_EQ(*ids.begin(), first_id);
+        EXPECT_EQ(ids.count(Package().get_id()), 0U);
+    }
+    // Zniszczony magazyn oddał ID
+    EXPECT_EQ(Package().get_id(), first_id);
+}
+
+/// Liczy paczki w drodze (bufory rampy, bufory i kolejki robotników) i sprawdza, że każda jest żywa w rejestrze
+std::size_t count_live_in_flight(const Factory& factory) {
+    const PackageLedger& ledger = *factory.get_package_ledger();
+    std::size_t in_flight = 0;
+    auto in_flight_package = [&ledger, &in_flight](const Package& package) {
+        EXPECT_TRUE(ledger.is_live(package.get_id()));
+        ++in_flight;
+    };
+    for (auto it = factory.ramp_cbegin(); it != factory.ramp_cend(); ++it) {
+        if (it->get_sending_buffer()) {in_flight_package(*it->get_sending_buffer());}
+    }
+    for (auto it = factory.worker_cbegin(); it != factory.worker_cend(); ++it) {
+        if (it->get_sending_buffer()) {in_flight_package(*it->get_sending_buffer());}
+        if (it->get_processing_buffer()) {in_flight_package(*it->get_processing_buffer());}
+        for (const Package& package : *it) {in_flight_package(package);}
+    }
+    return in_flight;
+}
+
+const char* ledger_chain_structure = "LOADING_RAMP id=1 delivery-interval=2\n"
+                                     "WORKER id=1 processing-time=3 queue-type=FIFO\n"
+                                     "STOREHOUSE id=1 stockpile-type=HANDLES\n"
+                                     "LINK src=ramp-1 dest=worker-1\n"
+                                     "LINK src=worker-1 dest=store-1\n";
+
+TEST(PackageLedgerTest, FactoryMintsAndRetires) {
+    std::istringstream iss(ledger_chain_structure);
+    Factory factory = load_factory_structure(iss);
+    EXPECT_EQ(factory.get_package_ledger(), nullptr);
+
+    // Paczka utworzona przez konstruktor rampy jest przyjmowana przy włączeniu rejestru
+    factory.enable_package_ledger(true);
+    const PackageLedger& ledger = *factory.get_package_ledger();
+    EXPECT_EQ(ledger.live_count(), 1U);
+
+    simulate(factory, 40, [](Factory&, Time) {});
+
+    std::size_t in_flight = count_live_in_flight(factory);
+    EXPECT_GT(in_flight, 5U);
+    EXPECT_EQ(ledger.live_count(), in_flight);
+
+    // Paczki w magazynie są wycofane
+    const auto& stockpile = dynamic_cast<const HandleStockpile&>(*factory.find_storehouse_by_id(1)->get_stockpile());
+    ASSERT_GT(stockpile.size(), 5U);
+    for (std::size_t i = 0; i < stockpile.size(); ++i) {
+        EXPECT_FALSE(ledger.is_live(stockpile.get_handles()[i].id));
+    }
+
+    // Usunięcie robotnika wycofuje jego paczki
+    factory.remove_worker(1);
+    EXPECT_EQ(ledger.live_count(), count_live_in_flight(factory));
+
+    std::ostringstream oss;
+    save_factory_structure(factory, oss);
+    EXPECT_NE(oss.str().find("STOREHOUSE id=1 stockpile-type=HANDLES"), std::string::npos);
+
+    factory.enable_package_ledger(false);
+    EXPECT_EQ(factory.get_package_ledger(), nullptr);
+}
+
+TEST(PackageLedgerTest, CountsSkipAheadPackages) {
+    // Paczki dopisane hurtowo do kolejek (push_new) też są w drodze
+    std::istringstream iss(ledger_chain_structure);
+    Factory factory = load_factory_structure(iss);
+    factory.enable_package_ledger(true);
+
+    SimulationOptions options;
+    options.skip_ahead = 200;
+    simulate(factory, 200, [](Factory&, Time) {}, options);
+
+    std::size_t in_flight = count_live_in_flight(factory);
+    EXPECT_GT(in_flight, 30U);
+    EXPECT_EQ(factory.get_package_ledger()->live_count(), in_flight);
+}
+
+TEST(PackageHandleQueueTest, IsFifoCorrectAcrossGrowth) {
+    PackageHandleQueue q(PackageQueueType::FIFO, 2);
+    q.push({1, 0, 0});
+    q.push({2, 0, 0});
+    EXPECT_EQ(q.pop().id, 1U);
+
+    // Zawinięcie bufora i powiększenie
+    for (ElementID id = 3; id <= 6; ++id) {
+        q.push({id, 0, 0});
+    }
+    EXPECT_EQ(q.size(), 5U);
+    EXPECT_GE(q.capacity(), 5U);
+    for (ElementID id = 2; id <= 6; ++id) {
+        EXPECT_EQ(q.pop().id, id);
+    }
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(PackageHandleQueueTest, BulkOperationsKeepPopOrder) {
+    std::vector<PackageHandle> in;
+    for (ElementID id = 1; id <= 10; ++id) {
+        in.push_back({id, 0, 0});
+    }
+
+    PackageHandleQueue fifo(PackageQueueType::FIFO, 4);
+    fifo.push({100, 0, 0});
+    fifo.pop();
+    fifo.push_bulk(in.data(), in.size());
+    ASSERT_EQ(fifo.size(), 10U);
+    EXPECT_EQ(fifo[0].id, 1U);
+
+    std::vector<PackageHandle> out(4);
+    EXPECT_EQ(fifo.pop_n(4, out.data()), 4U);
+    EXPECT_EQ(out[0].id, 1U);
+    EXPECT_EQ(out[3].id, 4U);
+
+    PackageHandleQueue lifo(PackageQueueType::LIFO);
+    lifo.push_bulk(in.data(), in.size());
+    EXPECT_EQ(lifo.pop_n(4, out.data()), 4U);
+    EXPECT_EQ(out[0].id, 10U);
+    EXPECT_EQ(out[3].id, 7U);
+    EXPECT_EQ(lifo.pop().id, 6U);
+}
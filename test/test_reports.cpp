@@ -3,6 +3,8 @@
 
 #include "factory.hpp"
 #include "reports.hpp"
+#include "async_reports.hpp"
+#include "simulation.hpp"
 
 #include <functional>
 
@@ -368,3 +370,134 @@ TEST(ReportsTest, TurnReportPackageInStock) {
 
     perform_turn_report_check(factory, t, expected_report_lines);
 }
+
+TEST(ReportsTest, TurnReportBufferedIsByteIdentical) {
+    Factory factory;
+    factory.add_worker(Worker(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+
+    Worker& w = *(factory.find_worker_by_id(1));
+    w.receive_package(Package(1));
+    w.receive_package(Package(2));
+    w.receive_package(Package(3));
+    w.do_work(1);
+
+    Storehouse& s = *(factory.find_storehouse_by_id(1));
+    s.receive_package(Package(4));
+    s.receive_package(Package(5));
+
+    std::string expected = "=== [ Turn: 1 ] ===\n\n"
+                           "== WORKERS ==\n\n"
+                           "WORKER #1\n"
+                           "  PBuffer: #1 (pt = 1)\n"
+                           "  Queue: #2, #3\n"
+                           "  SBuffer: (empty)\n"
+                           "\n"
+                           "\n== STOREHOUSES ==\n\n"
+                           "STOREHOUSE #1\n"
+                           "  Stock: #4, #5\n"
+                           "\n";
+
+    std::ostringstream oss;
+    generate_simulation_turn_report(factory, oss, 1);
+    EXPECT_EQ(oss.str(), expected);
+
+    std::ostringstream buffered_oss;
+    {
+        BufferedWriter writer(buffered_oss, 16);
+        generate_simulation_turn_report(factory, writer, 1);
+        EXPECT_EQ(writer.buffered_size(), 0U);
+    }
+    EXPECT_EQ(buffered_oss.str(), expected);
+}
+
+TEST(ReportsTest, AsyncTurnReportsMatchSynchronous) {
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_worker(Worker(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_worker(Worker(2, 3, std::make_unique<PackageQueue>(PackageQueueType::LIFO)));
+    factory.add_storehouse(Storehouse(1));
+
+    Ramp& r = *(factory.find_ramp_by_id(1));
+    r.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(1)));
+
+    Worker& w1 = *(factory.find_worker_by_id(1));
+    w1.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(2)));
+
+    Worker& w2 = *(factory.find_worker_by_id(2));
+    w2.receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+
+    std::ostringstream sync_oss;
+    std::ostringstream async_oss;
+    {
+        AsyncReportWriter async_writer(async_oss, 2);
+        simulate(factory, 10, [&sync_oss, &async_writer](Factory& f, Time t) {
+            generate_simulation_turn_report(f, sync_oss, t);
+            async_writer(f, t);
+        });
+        async_writer.close();
+    }
+
+    EXPECT_EQ(async_oss.str(), sync_oss.str());
+}
+
+TEST(ReportsTest, AsyncReportAfterCloseThrows) {
+    Factory factory;
+    factory.add_storehouse(Storehouse(1));
+
+    std::ostringstream oss;
+    AsyncReportWriter async_writer(oss, 1);
+    async_writer(factory, 1);
+    async_writer.close();
+
+    // Wątek zapisu już nie działa - raport nie może czekać na miejsce w kolejce
+    EXPECT_THROW(async_writer(factory, 2), std::logic_error);
+    EXPECT_THROW(async_writer(factory, 3), std::logic_error);
+    EXPECT_EQ(oss.str().find("Turn: 2"), std::string::npos);
+}
+
+TEST(ReportsTest, DeltaTurnReportsOnlyChangedNodes) {
+    // R -> W1 -> S1, W2 and S2 never change
+    Factory factory;
+    factory.add_ramp(Ramp(1, 2));
+    factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_worker(Worker(2, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+    factory.add_storehouse(Storehouse(2));
+
+    Ramp& r = *(factory.find_ramp_by_id(1));
+    r.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(1)));
+
+    Worker& w1 = *(factory.find_worker_by_id(1));
+    w1.receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+
+    Worker& w2 = *(factory.find_worker_by_id(2));
+    w2.receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(2)));
+
+    std::ostringstream oss;
+    DeltaTurnReporter reporter(oss, 3);
+    simulate(factory, 4, std::ref(reporter));
+
+    std::string report = oss.str();
+    auto turn_report = [&report](Time t) {
+        std::size_t begin = report.find("=== [ Turn: " + std::to_string(t));
+        std::size_t end = report.find("=== [ Turn: ", begin + 1);
+        return report.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+    };
+
+    // Klatki kluczowe: tura 1 i 4
+    EXPECT_NE(turn_report(1).find("WORKER #2"), std::string::npos);
+    EXPECT_NE(turn_report(4).find("STOREHOUSE #2"), std::string::npos);
+
+    for (Time t : {2, 3}) {
+        std::string delta = turn_report(t);
+        EXPECT_NE(delta.find("(changes)"), std::string::npos);
+        EXPECT_NE(delta.find("WORKER #1"), std::string::npos);
+        EXPECT_EQ(delta.find("WORKER #2"), std::string::npos);
+        EXPECT_EQ(delta.find("STOREHOUSE #2"), std::string::npos);
+    }
+
+    // Tura 2: W1 wysyła do S1, tura 3: S1 bez zmian
+    EXPECT_NE(turn_report(2).find("STOREHOUSE #1"), std::string::npos);
+    EXPECT_EQ(turn_report(3).find("STOREHOUSE #1"), std::string::npos);
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "generator.hpp"
+#include "reports.hpp"
+#include "scheduler.hpp"
+#include "simulation.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+std::vector<std::uint32_t> fired_by_modulo(const std::vector<TimeOffset>& periods, Time t) {
+    std::vector<std::uint32_t> fired;
+    for (std::size_t i = 0; i < periods.size(); ++i) {
+        if (t % periods[i] == 0) {
+            fired.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    return fired;
+}
+
+class CountdownSchedulerTest : public ::testing::TestWithParam<SchedulerKernel> {
+};
+
+TEST_P(CountdownSchedulerTest, MatchesModulo) {
+    if (!CountdownScheduler::is_supported(GetParam())) {
+        GTEST_SKIP() << "Kernel not supported by the CPU";
+    }
+
+    // 19 węzłów - pełne bloki SIMD i reszta skalarna
+    std::vector<TimeOffset> periods;
+    for (TimeOffset p = 1; p <= 19; ++p) {
+        periods.push_back(p % 7 + 1);
+    }
+
+    CountdownScheduler scheduler(GetParam());
+    scheduler.set_periods(periods);
+    for (Time t = 1; t <= 100; ++t) {
+        ASSERT_EQ(scheduler.advance(t), fired_by_modulo(periods, t)) << "t = " << t;
+    }
+
+    // Skok w czasie - ponowna synchronizacja
+    for (Time t : {250, 251, 252, 17, 18}) {
+        ASSERT_EQ(scheduler.advance(t), fired_by_modulo(periods, t)) << "t = " << t;
+    }
+}
+
+std::string kernel_name(const ::testing::TestParamInfo<SchedulerKernel>& info) {
+    const char* names[] = {"AUTO", "SCALAR", "SSE2", "AVX2"};
+    return names[static_cast<int>(info.param)];
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, CountdownSchedulerTest,
+                         ::testing::Values(SchedulerKernel::AUTO, SchedulerKernel::SCALAR,
+                                           SchedulerKernel::SSE2, SchedulerKernel::AVX2),
+                         kernel_name);
+
+TEST(CountdownSchedulerFactoryTest, SimulationMatchesModuloScheduling) {
+    FactoryGeneratorParameters params;
+    params.ramps = 5;
+    params.workers = 30;
+    params.storehouses = 3;
+    params.chain_depth = 3;
+    params.seed = 7;
+    // Jeden odbiorca na nadawcę - wybór odbiorcy nie zależy od losowania
+    params.fan_out = 1;
+
+    std::ostringstream structure;
+    {
+        BufferedWriter writer(structure);
+        generate_factory_structure(params, writer);
+    }
+
+    auto run = [&structure](bool countdown) {
+        std::istringstream iss(structure.str());
+        Factory factory = load_factory_structure(iss);
+        factory.enable_countdown_scheduling(countdown);
+
+        std::ostringstream reports;
+        simulate(factory, 40, [&reports](Factory& f, Time t) {
+            generate_simulation_turn_report(f, reports, t);
+        });
+        return reports.str();
+    };
+
+    EXPECT_EQ(run(true), run(false));
+}
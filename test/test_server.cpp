@@ -0,0 +1,191 @@
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "server.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+SimulationSession make_session() {
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=2\n"
+                           "WORKER id=1 processing-time=1 queue-type=FIFO\n"
+                           "STOREHOUSE id=1\n"
+                           "LINK src=ramp-1 dest=worker-1\n"
+                           "LINK src=worker-1 dest=store-1\n");
+    return SimulationSession(load_factory_structure(iss));
+}
+
+std::string send_lines(SimulationSession& session, const std::string& lines) {
+    std::istringstream iss(lines);
+    std::ostringstream out;
+    std::string line;
+    while (std::getline(iss, line)) {
+        session.handle_line(line, out);
+    }
+    return out.str();
+}
+
+TEST(SimulationSessionTest, SimulateContinuesFromCurrentTurn) {
+    SimulationSession session = make_session();
+
+    EXPECT_EQ(send_lines(session, "SIMULATE 10\nSIMULATE 5\n"), "TURN 10\nOK\nTURN 15\nOK\n");
+    EXPECT_EQ(session.get_time(), 15);
+    EXPECT_GT(session.get_factory().storehouse_cbegin()->get_stockpile()->size(), 0U);
+}
+
+TEST(SimulationSessionTest, PatchAppliedAtEnd) {
+    SimulationSession session = make_session();
+
+    EXPECT_EQ(send_lines(session, "PATCH\nADD STOREHOUSE id=2\nLINK src=worker-1 dest=store-2\n"), "");
+    EXPECT_EQ(session.get_factory().find_storehouse_by_id(2), session.get_factory().storehouse_cend());
+
+    EXPECT_EQ(send_lines(session, "END\n"), "OK\n");
+    EXPECT_NE(session.get_factory().find_storehouse_by_id(2), session.get_factory().storehouse_cend());
+}
+
+TEST(SimulationSessionTest, PatchRejectsDuplicateNode) {
+    SimulationSession session = make_session();
+
+    EXPECT_EQ(send_lines(session, "PATCH\nADD WORKER id=1 processing-time=3 queue-type=LIFO\nEND\n"),
+              "ERROR Duplicate node ID 1\n");
+    const Factory& factory = session.get_factory();
+    EXPECT_EQ(1, std::distance(factory.worker_cbegin(), factory.worker_cend()));
+    EXPECT_EQ(1, factory.find_worker_by_id(1)->get_processing_duration());
+}
+
+TEST(SimulationSessionTest, ErrorsKeepSessionUsable) {
+    SimulationSession session = make_session();
+
+    std::string response = send_lines(session, "STATISTICS\nFOO\nSIMULATE x\nPATCH\nREMOVE WORKER id=1\nEND\nSIMULATE 1\n");
+    EXPECT_EQ(response, "ERROR Statistics are disabled\n"
+                        "ERROR Unknown command FOO\n"
+                        "ERROR Invalid number of turns: x\n"
+                        "OK\n"
+                        "ERROR Factory is not consistent\n");
+}
+
+TEST(SimulationSessionTest, SimulateRejectsTimeOverflow) {
+    SimulationSession session = make_session();
+
+    // 5 + 2147483643 = 2^31 - poza zakresem Time, sesja pozostaje w turze 5
+    EXPECT_EQ(send_lines(session, "SIMULATE 5\nSIMULATE 2147483643\n"),
+              "TURN 5\nOK\nERROR Number of turns exceeds the time range: 2147483643\n");
+    EXPECT_EQ(session.get_time(), 5);
+}
+
+TEST(SimulationSessionTest, StatisticsAndSave) {
+    SimulationSession session = make_session();
+
+    std::string response = send_lines(session, "STATISTICS ON\nSIMULATE 20\nSTATISTICS\nSAVE\nMEMORY\n");
+    EXPECT_NE(response.find("STOREHOUSE #1"), std::string::npos);
+    EXPECT_NE(response.find("== MEMORY =="), std::string::npos);
+    EXPECT_NE(response.find("LINK src=worker-1 dest=store-1"), std::string::npos);
+
+    std::ostringstream out;
+    EXPECT_FALSE(session.handle_line("SHUTDOWN", out));
+    EXPECT_EQ(out.str(), "OK\n");
+}
+
+int connect_to(const std::string& path, int attempts) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+    int client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    for (int attempt = 1; ::connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0; ++attempt) {
+        if (attempt >= attempts) {
+            ::close(client);
+            return -1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return client;
+}
+
+/// Odbiera aż do `responses` odpowiedzi (zakończonych linią OK lub ERROR) albo do zamknięcia połączenia
+std::string request(int client, const std::string& lines, int responses) {
+    if (::send(client, lines.data(), lines.size(), 0) != static_cast<ssize_t>(lines.size())) {
+        return "";
+    }
+    std::string response;
+    char buffer[256];
+    auto finished = [&response, responses] {
+        int count = 0;
+        for (std::size_t begin = 0, end; (end = response.find('\n', begin)) != std::string::npos; begin = end + 1) {
+            std::string line = response.substr(begin, end - begin);
+            count += line == "OK" || line.rfind("ERROR", 0) == 0;
+        }
+        return responses >= 0 && count >= responses;
+    };
+    for (ssize_t received; !finished() && (received = ::recv(client, buffer, sizeof(buffer), 0)) > 0;) {
+        response.append(buffer, static_cast<std::size_t>(received));
+    }
+    return response;
+}
+
+TEST(SimulationServerTest, ServesCommandsOnSocket) {
+    SimulationSession session = make_session();
+    std::string path = "/tmp/symulacja_test_" + std::to_string(::getpid()) + ".sock";
+    ::unlink(path.c_str());
+    std::thread server([&session, &path] { serve_session(session, path); });
+
+    // Serwer może jeszcze nie nasłuchiwać
+    int client = connect_to(path, 100);
+    ASSERT_GE(client, 0);
+    std::string response = request(client, "SIMULATE 3\nSHUTDOWN\n", -1);
+    ::close(client);
+    server.join();
+
+    EXPECT_EQ(response, "TURN 3\nOK\nOK\n");
+    EXPECT_NE(::access(path.c_str(), F_OK), 0);
+}
+
+TEST(SimulationServerTest, ForkContinuesFromSameState) {
+    SimulationSession session = make_session();
+    std::string path = "/tmp/symulacja_test_" + std::to_string(::getpid()) + ".sock";
+    std::string fork_path = "/tmp/symulacja_test_fork_" + std::to_string(::getpid()) + ".sock";
+    ::unlink(path.c_str());
+    ::unlink(fork_path.c_str());
+    std::thread server([&session, &path] { serve_session(session, path); });
+
+    int client = connect_to(path, 100);
+    ASSERT_GE(client, 0);
+    std::string forked = request(client, "SIMULATE 3\nFORK " + fork_path + "\n", 2);
+    ASSERT_EQ(forked.rfind("TURN 3\nOK\nPID ", 0), 0U) << forked;
+
+    // Kopia nasłuchuje już w chwili odpowiedzi na FORK
+    int fork_client = connect_to(fork_path, 1);
+    ASSERT_GE(fork_client, 0);
+    std::string fork_response = request(fork_client, "SIMULATE 7\nREPORT\nSHUTDOWN\n", -1);
+    ::close(fork_client);
+
+    std::string response = request(client, "SIMULATE 7\nREPORT\nSHUTDOWN\n", -1);
+    ::close(client);
+    server.join();
+
+    EXPECT_EQ(response.rfind("TURN 10\nOK\n", 0), 0U) << response;
+    EXPECT_EQ(fork_response, response);
+}
+
+TEST(SimulationServerTest, RefusesToReplaceRegularFile) {
+    SimulationSession session = make_session();
+    std::string path = "/tmp/symulacja_test_file_" + std::to_string(::getpid());
+    {
+        std::ofstream file(path);
+        file << "dane\n";
+    }
+
+    EXPECT_THROW(serve_session(session, path), std::invalid_argument);
+    std::ifstream file(path);
+    std::string content;
+    std::getline(file, content);
+    EXPECT_EQ(content, "dane");
+    ::unlink(path.c_str());
+}
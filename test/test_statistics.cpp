@@ -0,0 +1,130 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "simulation.hpp"
+#include "statistics.hpp"
+
+#include <sstream>
+
+class StatisticsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // R -> W -> S
+        factory.add_ramp(Ramp(1, 2));
+        factory.add_worker(Worker(1, 3, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        factory.add_storehouse(Storehouse(1));
+
+        Ramp& r = *(factory.find_ramp_by_id(1));
+        r.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(1)));
+
+        Worker& w = *(factory.find_worker_by_id(1));
+        w.receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+    }
+
+    Factory factory;
+};
+
+TEST_F(StatisticsTest, DisabledByDefault) {
+    SimulationSummary summary = simulate(factory, 5, [](Factory&, Time) {});
+
+    EXPECT_EQ(summary.turns, 5);
+    EXPECT_FALSE(summary.statistics.has_value());
+    EXPECT_EQ(factory.find_worker_by_id(1)->get_statistics().busy_turns, 0U);
+}
+
+TEST_F(StatisticsTest, CountersMatchPackageFlow) {
+    factory.enable_statistics(true);
+    SimulationSummary summary = simulate(factory, 20, [](Factory&, Time) {});
+
+    ASSERT_TRUE(summary.statistics.has_value());
+    const StatisticsSummary& stats = *summary.statistics;
+    EXPECT_EQ(stats.turns, 20);
+
+    ASSERT_EQ(stats.workers.size(), 1U);
+    const WorkerSummary& w = stats.workers[0];
+    EXPECT_EQ(w.busy_turns + w.idle_turns, 20U);
+    EXPECT_GT(w.utilization, 0.0);
+    EXPECT_LE(w.utilization, 1.0);
+
+    // Wszystko co opuściło robotnika trafiło do magazynu
+    ASSERT_EQ(stats.storehouses.size(), 1U);
+    EXPECT_EQ(stats.storehouses[0].packages_received, w.packages_sent);
+    EXPECT_DOUBLE_EQ(stats.storehouses[0].throughput, static_cast<double>(w.packages_sent) / 20);
+
+    // Paczka z konstruktora rampy nie jest liczona jako dostawa
+    ASSERT_EQ(stats.ramps.size(), 1U);
+    EXPECT_EQ(stats.ramps[0].packages_sent, stats.ramps[0].deliveries + 1);
+
+    std::ostringstream oss;
+    generate_statistics_report(stats, oss);
+    EXPECT_NE(oss.str().find("WORKER #1"), std::string::npos);
+}
+
+TEST(LatencyHistogramTest, PercentilesOfKnownDistribution) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.percentile(0.5), 0);
+
+    for (Time value = 1; value <= 1000; ++value)
+    {
+        histogram.record(value);
+    }
+
+    EXPECT_EQ(histogram.count(), 1000U);
+    EXPECT_EQ(histogram.max(), 1000);
+
+    // Wartości poniżej 16 są dokładne, powyżej błąd względny < 12.5%
+    Time p50 = histogram.percentile(0.5);
+    EXPECT_GE(p50, 500);
+    EXPECT_LE(p50, 500 * 9 / 8);
+    Time p99 = histogram.percentile(0.99);
+    EXPECT_GE(p99, 990);
+    EXPECT_LE(p99, 1000);
+    EXPECT_EQ(histogram.percentile(1.0), 1000);
+    EXPECT_EQ(histogram.percentile(0.005), 5);
+}
+
+TEST_F(StatisticsTest, LatencyIsMeasuredFromRampToStorehouse) {
+    factory.enable_statistics(true);
+    SimulationSummary summary = simulate(factory, 30, [](Factory&, Time) {});
+
+    ASSERT_TRUE(summary.statistics.has_value());
+    const StatisticsSummary& stats = *summary.statistics;
+
+    // Rampa tworzy paczkę w turze nieparzystej, wysyła w następnej; robotnik kończy w turze podzielnej przez 3
+    const LatencySummary& latency = stats.storehouses[0].latency;
+    EXPECT_GT(latency.p50, 0);
+    EXPECT_LE(latency.p50, latency.p99);
+    EXPECT_LE(latency.p99, latency.p999);
+    EXPECT_LE(latency.p999, latency.max);
+    EXPECT_LE(latency.max, 30);
+
+    const LatencySummary& queue_wait = stats.workers[0].queue_wait;
+    EXPECT_LE(queue_wait.p50, queue_wait.max);
+    EXPECT_LT(queue_wait.max, latency.max);
+
+    std::ostringstream oss;
+    generate_statistics_report(stats, oss);
+    EXPECT_NE(oss.str().find("Latency: p50"), std::string::npos);
+    EXPECT_NE(oss.str().find("Queue wait: p50"), std::string::npos);
+}
+
+TEST(StatisticsBackpressureTest, SaturatedWorkerIsVisible) {
+    // Rampa dostarcza co 2 tury, robotnik przetwarza 7 tur z kolejką na jedną paczkę
+    Factory factory;
+    factory.add_ramp(Ramp(1, 2));
+    factory.add_worker(Worker(1, 7, std::make_unique<PackageQueue>(PackageQueueType::FIFO), 1));
+    factory.add_storehouse(Storehouse(1));
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(1)));
+    factory.find_worker_by_id(1)->receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+
+    factory.enable_statistics(true);
+    SimulationSummary summary = simulate(factory, 50, [](Factory& f, Time) {
+        EXPECT_LE(f.find_worker_by_id(1)->get_queue()->size(), 1U);
+    });
+
+    const StatisticsSummary& stats = *summary.statistics;
+    EXPECT_GT(stats.ramps[0].blocked_sends, 0U);
+    EXPECT_EQ(stats.ramps[0].rerouted_packages, 0U);
+    EXPECT_GT(stats.workers[0].full_turns, 0U);
+}
@@ -31,3 +31,111 @@ TEST(PackageQueueTest, IsLifoCorrect) {
     p = q.pop();
     EXPECT_EQ(p.get_id(), 1);
 }
+
+TEST(StockpileTest, IsCountingStockpileCorrect) {
+    CountingStockpile s;
+    EXPECT_TRUE(s.empty());
+    s.push(Package(1));
+    s.push(Package(2));
+
+    EXPECT_EQ(s.size(), 2U);
+    EXPECT_EQ(s.cbegin(), s.cend());
+
+    // ID zwolnione od razu po przyjęciu paczki
+    Package p;
+    EXPECT_EQ(p.get_id(), 1);
+}
+
+TEST(StockpileTest, PushNewCreatesPackages) {
+    CountingStockpile counting;
+    counting.push_new(1000);
+    EXPECT_EQ(counting.size(), 1000U);
+
+    PackageQueue queue(PackageQueueType::FIFO);
+    queue.push_new(3);
+    EXPECT_EQ(queue.size(), 3U);
+    EXPECT_NE(queue.pop().get_id(), queue.pop().get_id());
+}
+
+TEST(StockpileTest, IsRingStockpileKeepingLastPackages) {
+    RingStockpile s(2);
+    s.push(Package(1));
+    s.push(Package(2));
+    s.push(Package(3));
+
+    ASSERT_EQ(s.size(), 2U);
+    EXPECT_EQ(s.cbegin()->get_id(), 2);
+    EXPECT_EQ(std::next(s.cbegin())->get_id(), 3);
+
+    EXPECT_THROW(RingStockpile(0), std::invalid_argument);
+}
+
+TEST(PackageQueueTest, IsBulkPushPopCorrect) {
+    PackageQueue q(PackageQueueType::LIFO);
+    std::vector<Package> packages;
+    packages.emplace_back(1);
+    packages.emplace_back(2);
+    packages.emplace_back(3);
+
+    q.push_bulk(std::move(packages));
+    EXPECT_TRUE(packages.empty());
+    ASSERT_EQ(q.size(), 3U);
+
+    std::vector<Package> out;
+    EXPECT_EQ(q.pop_n(2, out), 2U);
+    ASSERT_EQ(out.size(), 2U);
+    EXPECT_EQ(out[0].get_id(), 3);
+    EXPECT_EQ(out[1].get_id(), 2);
+
+    EXPECT_EQ(q.pop_n(5, out), 1U);
+    EXPECT_EQ(out[2].get_id(), 1);
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(PackageQueueTest, IsDrainIntoInPopOrder) {
+    PackageQueue lifo(PackageQueueType::LIFO);
+    lifo.push(Package(1));
+    lifo.push(Package(2));
+    lifo.push(Package(3));
+
+    // Do innej kolejki - przez przepięcie węzłów listy
+    PackageQueue fifo(PackageQueueType::FIFO);
+    fifo.push(Package(4));
+    EXPECT_EQ(lifo.drain_into(fifo), 3U);
+    EXPECT_TRUE(lifo.empty());
+
+    std::vector<Package> out;
+    fifo.pop_n(4, out);
+    ASSERT_EQ(out.size(), 4U);
+    EXPECT_EQ(out[0].get_id(), 4);
+    EXPECT_EQ(out[1].get_id(), 3);
+    EXPECT_EQ(out[2].get_id(), 2);
+    EXPECT_EQ(out[3].get_id(), 1);
+
+    // Do dowolnego magazynu - przez push()
+    fifo.push_bulk(std::move(out));
+    RingStockpile ring(2);
+    EXPECT_EQ(fifo.drain_into(ring), 4U);
+    ASSERT_EQ(ring.size(), 2U);
+    EXPECT_EQ(ring.cbegin()->get_id(), 2);
+}
+
+TEST(StaticPackageQueueTest, IsDisciplineFixedAtCompileTime) {
+    StaticFifoQueue fifo;
+    StaticLifoQueue lifo;
+    for (ElementID id = 1; id <= 2; ++id) {
+        fifo.push(Package(id));
+        lifo.push(Package(id + 2));
+    }
+
+    EXPECT_EQ(fifo.get_queue_type(), PackageQueueType::FIFO);
+    EXPECT_EQ(fifo.pop().get_id(), 1);
+    EXPECT_EQ(lifo.get_queue_type(), PackageQueueType::LIFO);
+    EXPECT_EQ(lifo.pop().get_id(), 4);
+
+    // Nadal dostępna przez interfejs wirtualny
+    IPackageQueue& q = lifo;
+    std::vector<Package> out;
+    EXPECT_EQ(q.pop_n(5, out), 1U);
+    EXPECT_EQ(out[0].get_id(), 3);
+}
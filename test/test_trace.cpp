@@ -0,0 +1,61 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "simulation.hpp"
+#include "trace.hpp"
+
+#include <filesystem>
+
+TEST(TraceTest, WriteAndReadBack) {
+    Factory factory;
+    factory.add_ramp(Ramp(1, 2));
+    factory.add_worker(Worker(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+
+    Ramp& r = *(factory.find_ramp_by_id(1));
+    r.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(1)));
+
+    Worker& w = *(factory.find_worker_by_id(1));
+    w.receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+
+    std::string path = (std::filesystem::temp_directory_path() / "SymulacjaSieci_trace_test.bin").string();
+    {
+        TraceWriter trace(path, 2);
+        simulate(factory, 5, std::ref(trace));
+    }
+
+    TraceReader reader(path);
+    EXPECT_EQ(reader.get_worker_ids(), std::vector<ElementID>{1});
+    EXPECT_EQ(reader.get_storehouse_ids(), std::vector<ElementID>{1});
+
+    TraceChunk chunk;
+    std::vector<Time> times;
+    std::size_t chunks = 0;
+    while (reader.read_chunk(chunk)) {
+        times.insert(times.end(), chunk.times.begin(), chunk.times.end());
+        ++chunks;
+    }
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(chunks, 3U);
+    EXPECT_EQ(times, (std::vector<Time>{1, 2, 3, 4, 5}));
+
+    // Ostatni wiersz odpowiada stanowi fabryki po symulacji
+    ASSERT_EQ(chunk.turns(), 1U);
+    EXPECT_EQ(chunk.queue_lengths[0], w.get_queue()->size());
+    EXPECT_EQ(chunk.processing_buffers[0], w.get_processing_buffer() ? w.get_processing_buffer()->get_id() : 0);
+    EXPECT_EQ(chunk.sending_buffers[0], w.get_sending_buffer() ? w.get_sending_buffer()->get_id() : 0);
+    EXPECT_EQ(chunk.stock_counts[0], factory.find_storehouse_by_id(1)->get_stockpile()->size());
+}
+
+TEST(TraceTest, NotATraceFile) {
+    std::string path = (std::filesystem::temp_directory_path() / "SymulacjaSieci_not_trace.bin").string();
+    {
+        std::ofstream ofs(path);
+        ofs << "LOADING_RAMP id=1 delivery-interval=3\n";
+    }
+
+    EXPECT_THROW(TraceReader reader(path), std::runtime_error);
+    std::filesystem::remove(path);
+}
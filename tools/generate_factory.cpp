@@ -0,0 +1,71 @@
+#include "generator.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --ramps N                  number of loading ramps (default 1)\n"
+              << "  --workers N                number of workers (default 1)\n"
+              << "  --storehouses N            number of storehouses (default 1)\n"
+              << "  --fan-out N                receivers per sender (default 2)\n"
+              << "  --depth N                  number of worker layers (default 1)\n"
+              << "  --cycles N                 back links between workers (default 0)\n"
+              << "  --lifo-ratio R             fraction of LIFO workers (default 0.5)\n"
+              << "  --max-delivery-interval N  (default 5)\n"
+              << "  --max-processing-time N    (default 5)\n"
+              << "  --seed N                   (default 1)\n"
+              << "  --output PATH              output file (default: standard output)\n";
+}
+
+int main(int argc, char* argv[])
+{
+    FactoryGeneratorParameters params;
+    std::string output;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string option = argv[i];
+            if (option == "--help" || option == "-h")
+            {
+                print_usage(argv[0]);
+                return 0;
+            }
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("Missing value for " + option);
+            }
+            std::string value = argv[++i];
+
+            if (option == "--ramps") {params.ramps = std::stoull(value);}
+            else if (option == "--workers") {params.workers = std::stoull(value);}
+            else if (option == "--storehouses") {params.storehouses = std::stoull(value);}
+            else if (option == "--fan-out") {params.fan_out = std::stoull(value);}
+            else if (option == "--depth") {params.chain_depth = std::stoull(value);}
+            else if (option == "--cycles") {params.cycles = std::stoull(value);}
+            else if (option == "--lifo-ratio") {params.lifo_ratio = std::stod(value);}
+            else if (option == "--max-delivery-interval") {params.max_delivery_interval = std::stoi(value);}
+            else if (option == "--max-processing-time") {params.max_processing_time = std::stoi(value);}
+            else if (option == "--seed") {params.seed = std::stoull(value);}
+            else if (option == "--output") {output = value;}
+            else {throw std::invalid_argument("Unknown option " + option);}
+        }
+
+        std::unique_ptr<BufferedWriter> writer = output.empty() ? std::make_unique<BufferedWriter>(1)
+                                                                : std::make_unique<BufferedWriter>(output);
+        generate_factory_structure(params, *writer);
+    }
+    catch (std::exception& err)
+    {
+        std::cerr << err.what() << "\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+    return 0;
+}